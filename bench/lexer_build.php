@@ -0,0 +1,72 @@
+<?php
+
+/* Time Lexer::build() on large synthetic rule sets.
+
+	php -d extension=parle.so bench/lexer_build.php [runs]
+*/
+
+use Parle\Lexer;
+
+$runs = isset($argv[1]) ? (int)$argv[1] : 3;
+
+/* Keywords followed by a catch-all identifier rule. */
+function keywords(int $n) : Lexer
+{
+	$lex = new Lexer;
+	for ($i = 0; $i < $n; $i++) {
+		$lex->push(base_convert((string)$i, 10, 26) . "kw", $i + 1);
+	}
+	$lex->push("[a-z_][a-z0-9_]*", $n + 1);
+	$lex->push("\\s+", $n + 2);
+
+	return $lex;
+}
+
+/* The same keywords looked up through Lexer::keywords(). */
+function table(int $n) : Lexer
+{
+	$lex = new Lexer;
+	$map = array();
+	for ($i = 0; $i < $n; $i++) {
+		$map[base_convert((string)$i, 10, 26) . "kw"] = $i + 1;
+	}
+	$lex->push("[a-z_][a-z0-9_]*", $n + 1);
+	$lex->push("\\s+", $n + 2);
+	$lex->keywords($map, $n + 1);
+
+	return $lex;
+}
+
+/* Overlapping character classes and bounded repeats. */
+function classes(int $n) : Lexer
+{
+	$lex = new Lexer;
+	for ($i = 0; $i < $n; $i++) {
+		$a = chr(ord("a") + $i % 26);
+		$b = chr(ord("a") + intdiv($i, 26) % 26);
+		$lex->push("[$a-z]$b" . "[0-9]{1,3}" . ($i % 97), $i + 1);
+	}
+	$lex->push("\\s+", $n + 1);
+
+	return $lex;
+}
+
+/* Eager, then lazy with a cache of 4096 rows. The lazy time includes
+	lexing a sample, which builds the rows it needs. */
+foreach (array("keywords", "table", "classes") as $name) {
+	foreach (array(1000, 10000) as $size) {
+		foreach (array(0, 4096) as $lazy) {
+			$best = INF;
+			for ($r = 0; $r < $runs; $r++) {
+				$lex = $name($size);
+				$t = microtime(true);
+				$lex->build($lazy);
+				if ($lazy) {
+					$lex->countTokens("7kw 1akw2 foo_bar b9 ckw xyz " . str_repeat("gkw h ", 100));
+				}
+				$best = min($best, microtime(true) - $t);
+			}
+			printf("%-8s n=%-5d %-5s %9.1f ms\n", $name, $size, $lazy ? "lazy" : "eager", $best * 1000);
+		}
+	}
+}
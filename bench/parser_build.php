@@ -0,0 +1,81 @@
+<?php
+
+/* Time Parser::build() on large synthetic grammars.
+
+	php -d extension=parle.so bench/parser_build.php [statements] [runs]
+*/
+
+use Parle\Parser;
+
+$n = isset($argv[1]) ? (int)$argv[1] : 750;
+$runs = isset($argv[2]) ? (int)$argv[2] : 3;
+
+/* Many alternatives: one statement kind per keyword. */
+function stmts(int $n) : Parser
+{
+	$p = new Parser;
+	$toks = "ID NUM";
+	for ($i = 0; $i < $n; $i++) {
+		$toks .= " KW$i";
+	}
+	$p->token($toks);
+	$p->left("'+' '-'");
+	$p->left("'*' '/'");
+
+	$p->push("start", "stmts");
+	$p->push("stmts", "stmts stmt");
+	$p->push("stmts", "stmt");
+	for ($i = 0; $i < $n; $i++) {
+		$p->push("stmt", "s$i");
+		$p->push("s$i", "KW$i expr ';'");
+		$p->push("s$i", "KW$i '(' args ')' block");
+	}
+	$p->push("block", "'{' stmts '}'");
+	$p->push("block", "'{' '}'");
+	foreach (array("'+'", "'-'", "'*'", "'/'") as $op) {
+		$p->push("expr", "expr $op expr");
+	}
+	$p->push("expr", "'(' expr ')'");
+	$p->push("expr", "ID");
+	$p->push("expr", "NUM");
+	$p->push("expr", "ID '(' args ')'");
+	$p->push("args", "%empty");
+	$p->push("args", "arglist");
+	$p->push("arglist", "arglist ',' expr");
+	$p->push("arglist", "expr");
+
+	return $p;
+}
+
+/* Deep precedence chain: every state closes over every level. */
+function chain(int $n) : Parser
+{
+	$p = new Parser;
+	$toks = "ID";
+	for ($i = 0; $i < $n; $i++) {
+		$toks .= " OP$i";
+	}
+	$p->token($toks);
+
+	$p->push("start", "e0");
+	for ($i = 0; $i < $n; $i++) {
+		$next = $i + 1;
+		$p->push("e$i", "e$i OP$i e$next");
+		$p->push("e$i", "e$next");
+	}
+	$p->push("e$n", "ID");
+	$p->push("e$n", "'(' e0 ')'");
+
+	return $p;
+}
+
+foreach (array("stmts" => $n, "chain" => intdiv($n, 3)) as $name => $size) {
+	$best = INF;
+	for ($r = 0; $r < $runs; $r++) {
+		$p = $name($size);
+		$t = microtime(true);
+		$p->build();
+		$best = min($best, microtime(true) - $t);
+	}
+	printf("%-6s n=%-5d %9.1f ms\n", $name, $size, $best * 1000);
+}
@@ -7,6 +7,7 @@ PHP_ARG_ENABLE(parle, whether to enable parle support,
 if test "$PHP_PARLE" != "no"; then
   PHP_REQUIRE_CXX()
   PHP_ADD_LIBRARY(stdc++,,PARLE_SHARED_LIBADD)
+  PHP_ADD_LIBRARY(pthread,,PARLE_SHARED_LIBADD)
 
   AC_DEFINE(HAVE_PARLE,1,[ ])
   PHP_SUBST(PARLE_SHARED_LIBADD)
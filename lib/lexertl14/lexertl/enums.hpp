@@ -16,8 +16,10 @@ namespace lexertl
     enum {end_state_index, id_index, user_id_index, push_dfa_index,
         next_dfa_index, eol_index, dead_state_index, transitions_index};
     // Rule flags:
+    // lazy_bit is only used by lookup() and never set in the rules.
     enum feature_flags {bol_bit = 1, eol_bit = 2, skip_bit = 4, again_bit = 8,
-        multi_state_bit = 16, recursive_bit = 32, advance_bit = 64};
+        multi_state_bit = 16, recursive_bit = 32, advance_bit = 64,
+        lazy_bit = 128};
     // End state flags:
     enum {end_state_bit = 1, pop_dfa_bit = 2};
 }
@@ -7,15 +7,19 @@
 #define LEXERTL_GENERATOR_HPP
 
 #include <algorithm>
+#include <atomic>
+#include <exception>
 #include "partition/charset.hpp"
 #include "char_traits.hpp"
 #include "partition/equivset.hpp"
 #include <list>
 #include <memory>
+#include <set>
 #include "parser/parser.hpp"
 #include "rules.hpp"
 #include "state_machine.hpp"
 #include <type_traits>
+#include <unordered_map>
 
 namespace lexertl
 {
@@ -32,58 +36,125 @@ public:
     using node = typename parser::node;
     using node_ptr_vector = typename parser::node_ptr_vector;
 
+    // Runner for build() that builds one DFA after the other.
+    struct serial_runner
+    {
+        template<typename task>
+        void operator()(const std::size_t count_, const task &task_) const
+        {
+            for (std::size_t index_ = 0; index_ < count_; ++index_)
+            {
+                task_(index_);
+            }
+        }
+    };
+
     static void build(const rules &rules_, sm &sm_)
+    {
+        build(rules_, sm_, serial_runner());
+    }
+
+    // As above, but the DFA of each lexer state is built by calling
+    // run_(count_, task_). run_ must call task_(index_) exactly once for
+    // every index_ < count_ before returning and may do so concurrently;
+    // task_ does not throw. char_state_machine DFAs are appended in
+    // order, so those are always built serially.
+    template<typename runner>
+    static void build(const rules &rules_, sm &sm_, const runner &run_)
+    {
+        build(rules_, sm_, run_, ~static_cast<std::size_t>(0));
+    }
+
+    // As above, but a lexer state whose DFA needs more than max_rows_
+    // rows is built as by build_lazy() instead, with a cache of
+    // max_rows_ rows. That bounds the time and memory taken by rules
+    // that make the DFA explode. Lexer states using ^ or $ and
+    // char_state_machine DFAs are always built in full.
+    template<typename runner>
+    static void build(const rules &rules_, sm &sm_, const runner &run_,
+        const std::size_t max_rows_)
     {
         const std::size_t size_ = rules_.statemap().size();
         // Strong exception guarantee
         // http://www.boost.org/community/exception_safety.html
         internals internals_;
         sm temp_sm_;
-        node_ptr_vector node_ptr_vector_;
+        // One per DFA so that the trees can be built independently.
+        std::vector<node_ptr_vector> node_ptr_vectors_(size_);
+        std::vector<std::exception_ptr> errors_(size_);
+        // Lowest lexer state that failed so far. Later states are
+        // skipped, as the build is going to throw anyway.
+        std::atomic<std::size_t> failed_(size_);
+        // Lexer states over budget
+        auto lazy_ = std::make_unique<lazy_dfa>(size_, max_rows_);
 
         internals_._eoi = rules_.eoi();
         internals_.add_states(size_);
 
-        for (id_type index_ = 0; index_ < size_; ++index_)
+        const auto task_ = [&](const std::size_t index_)
         {
-            if (rules_.regexes()[index_].empty())
+            if (index_ > failed_) return;
+
+            try
             {
-                std::ostringstream ss_;
+                const id_type id_ = static_cast<id_type>(index_);
 
-                ss_ << "Lexer states with no rules are not allowed "
-                    "(lexer state " << index_ << ".)";
-                throw runtime_error(ss_.str());
+                if (!build_state(rules_, id_, node_ptr_vectors_[index_],
+                    internals_, temp_sm_, max_rows_))
+                {
+                    node_ptr_vector().swap(node_ptr_vectors_[index_]);
+                    build_lazy_state(rules_, id_, *lazy_, internals_,
+                        temp_sm_);
+                }
             }
-            else
+            catch (...)
             {
-                // Note that the following variables are per DFA.
-                // Map of regex charset tokens (strings) to index
-                charset_map charset_map_;
-                // Used to fix up $ and \n clashes.
-                id_type nl_id_ = sm_traits::npos();
-                // Regex syntax tree
-                observer_ptr<node> root_ = build_tree(rules_, index_,
-                    node_ptr_vector_, charset_map_, nl_id_);
-
-                build_dfa(charset_map_, root_, internals_, temp_sm_, index_,
-                    nl_id_);
-
-                if (internals_._dfa[index_].size() /
-                    internals_._dfa_alphabet[index_] >= sm_traits::npos())
+                std::size_t failed_index_ = failed_;
+
+                errors_[index_] = std::current_exception();
+
+                while (index_ < failed_index_ &&
+                    !failed_.compare_exchange_weak(failed_index_, index_))
                 {
-                    // Overflow
-                    throw runtime_error("The data type you have chosen "
-                        "cannot hold this many DFA rows.");
                 }
             }
+        };
+
+        run_dfas(size_, task_, run_, lookup());
+
+        // Report the error of the lowest lexer state, as a serial
+        // build would.
+        for (const auto &error_ : errors_)
+        {
+            if (error_)
+            {
+                std::rethrow_exception(error_);
+            }
+        }
+
+        if (lazy_->any())
+        {
+            internals_._lazy = std::move(lazy_);
         }
 
         // If you get a compile error here the id_type from rules and
         // state machine do no match.
-        create(internals_, temp_sm_, rules_.features(), lookup());
+        create(internals_, temp_sm_, rules_, lookup());
         sm_.swap(temp_sm_);
     }
 
+    // As build(), but the DFA rows are only built once lookup() first
+    // reaches them. Between tokens each lexer state keeps at most
+    // max_states_ rows and starts over when it holds more. Lexer states
+    // using ^ or $ are built in full. lookup() changes a lazily built
+    // state machine, so it must not be used by several threads at once.
+    // Call sm::complete() before inspecting the tables directly.
+    static void build_lazy(const rules &rules_, sm &sm_,
+        const std::size_t max_states_)
+    {
+        build_lazy(rules_, sm_, max_states_, lookup());
+    }
+
     static observer_ptr<node> build_tree(const rules &rules_,
         const std::size_t dfa_, node_ptr_vector &node_ptr_vector_,
         charset_map &charset_map_, id_type &nl_id_)
@@ -104,11 +175,11 @@ public:
         auto push_dfa_iter_ = pushes_[dfa_].cbegin();
         auto pop_dfa_iter_ = pops_[dfa_].cbegin();
         const bool seen_bol_ = (rules_.features()[dfa_] & bol_bit) != 0;
-        observer_ptr<node> root_ = nullptr;
+        node_vector roots_;
 
-        root_ = parser_.parse(*regex_iter_, *id_iter_, *user_id_iter_,
-            *next_dfa_iter_, *push_dfa_iter_, *pop_dfa_iter_,
-            rules_.flags(), nl_id_, seen_bol_);
+        roots_.push_back(parser_.parse(*regex_iter_, *id_iter_,
+            *user_id_iter_, *next_dfa_iter_, *push_dfa_iter_, *pop_dfa_iter_,
+            rules_.flags(), nl_id_, seen_bol_));
         ++regex_iter_;
         ++id_iter_;
         ++user_id_iter_;
@@ -119,15 +190,10 @@ public:
         // Build syntax trees
         while (regex_iter_ != regex_iter_end_)
         {
-            observer_ptr<node> rhs_ = parser_.parse(*regex_iter_, *id_iter_,
+            roots_.push_back(parser_.parse(*regex_iter_, *id_iter_,
                 *user_id_iter_, *next_dfa_iter_, *push_dfa_iter_,
                 *pop_dfa_iter_, rules_.flags(), nl_id_,
-                (rules_.features()[dfa_] & bol_bit) != 0);
-
-            node_ptr_vector_.emplace_back
-                (std::make_unique<selection_node>(root_, rhs_));
-            root_ = node_ptr_vector_.back().get();
-
+                (rules_.features()[dfa_] & bol_bit) != 0));
             ++regex_iter_;
             ++id_iter_;
             ++user_id_iter_;
@@ -136,6 +202,32 @@ public:
             ++pop_dfa_iter_;
         }
 
+        // Join the rules pairwise rather than as one left leaning chain.
+        // Each selection node copies the firstpos/lastpos of both
+        // children, so a chain is quadratic in the number of rules. The
+        // root firstpos comes out in the same order either way.
+        while (roots_.size() > 1)
+        {
+            const std::size_t size_ = roots_.size();
+            std::size_t out_ = 0;
+
+            for (std::size_t i_ = 0; i_ + 1 < size_; i_ += 2)
+            {
+                node_ptr_vector_.emplace_back(std::make_unique<selection_node>
+                    (roots_[i_], roots_[i_ + 1]));
+                roots_[out_++] = node_ptr_vector_.back().get();
+            }
+
+            if (size_ % 2)
+            {
+                roots_[out_++] = roots_.back();
+            }
+
+            roots_.resize(out_);
+        }
+
+        observer_ptr<node> root_ = roots_.front();
+
         return root_;
     }
 
@@ -151,32 +243,403 @@ protected:
     using internals = detail::basic_internals<id_type>;
     using id_type_set = typename std::set<id_type>;
     using id_type_vector = typename internals::id_type_vector;
-    using index_set = typename charset::index_set;
-    using index_set_vector = std::vector<index_set>;
+    using index_vector = typename charset::index_vector;
+    using index_vector_vector = std::vector<index_vector>;
     using is_dfa = std::integral_constant<bool, sm_traits::is_dfa>;
     using lookup = std::integral_constant<bool, sm_traits::lookup>;
-    using node_set = std::set<observer_ptr<const node>>;
-    using node_set_vector = std::vector<std::unique_ptr<node_set>>;
+    using size_t_vector = typename std::vector<std::size_t>;
     using node_vector = typename node::node_vector;
+    // DFA state lookup: hash of the position set -> state indexes
+    using state_map = std::unordered_map<std::size_t, size_t_vector>;
     using node_vector_vector = std::vector<std::unique_ptr<node_vector>>;
     using selection_node = typename parser::selection_node;
-    using size_t_vector = typename std::vector<std::size_t>;
     using string_token = typename parser::string_token;
 
-    static void build_dfa(const charset_map &charset_map_,
+    // char_state_machine version
+    template<typename task, typename runner>
+    static void run_dfas(const std::size_t size_, const task &task_,
+        const runner &, const std::false_type &)
+    {
+        for (std::size_t index_ = 0; index_ < size_; ++index_)
+        {
+            task_(index_);
+        }
+    }
+
+    // state_machine version
+    template<typename task, typename runner>
+    static void run_dfas(const std::size_t size_, const task &task_,
+        const runner &run_, const std::true_type &)
+    {
+        run_(size_, task_);
+    }
+
+    static void check_state(const rules &rules_, const id_type index_)
+    {
+        if (rules_.regexes()[index_].empty())
+        {
+            std::ostringstream ss_;
+
+            ss_ << "Lexer states with no rules are not allowed "
+                "(lexer state " << index_ << ".)";
+            throw runtime_error(ss_.str());
+        }
+    }
+
+    static void check_rows(const id_type_vector &dfa_,
+        const std::size_t dfa_alphabet_)
+    {
+        if (dfa_.size() / dfa_alphabet_ >= sm_traits::npos())
+        {
+            // Overflow
+            throw runtime_error("The data type you have chosen "
+                "cannot hold this many DFA rows.");
+        }
+    }
+
+    // Fixing up $ and \n clashes and ^ edits rows other than the one
+    // being built, so those DFAs can't be built lazily.
+    static bool full_only(const rules &rules_, const id_type index_,
+        const id_type nl_id_)
+    {
+        return !lookup::value || nl_id_ != sm_traits::npos() ||
+            (rules_.features()[index_] & (bol_bit | eol_bit)) != 0;
+    }
+
+    // Only touches the index_ entries of internals_, so separate lexer
+    // states can be built at the same time. Returns false, leaving a
+    // partial DFA, if it needs more than max_rows_ rows and could be
+    // built lazily instead.
+    static bool build_state(const rules &rules_, const id_type index_,
+        node_ptr_vector &node_ptr_vector_, internals &internals_, sm &sm_,
+        const std::size_t max_rows_)
+    {
+        check_state(rules_, index_);
+
+        // Note that the following variables are per DFA.
+        // Map of regex charset tokens (strings) to index
+        charset_map charset_map_;
+        // Used to fix up $ and \n clashes.
+        id_type nl_id_ = sm_traits::npos();
+        // Regex syntax tree
+        observer_ptr<node> root_ = build_tree(rules_, index_,
+            node_ptr_vector_, charset_map_, nl_id_);
+
+        if (!build_dfa(charset_map_, root_, internals_, sm_, index_, nl_id_,
+            full_only(rules_, index_, nl_id_) ?
+            ~static_cast<std::size_t>(0) : max_rows_))
+        {
+            return false;
+        }
+
+        check_rows(internals_._dfa[index_], internals_._dfa_alphabet[index_]);
+        return true;
+    }
+
+    // Builds the rows of the lazily built DFAs on demand.
+    class lazy_dfa : public detail::basic_lazy_dfa<id_type>
+    {
+    public:
+        // What a DFA needs to work out its rows. Never changes once
+        // built, so copies of the state machine share it.
+        struct graph
+        {
+            node_ptr_vector _node_ptr_vector;
+            node_vector _followpos;
+            index_vector_vector _set_mapping;
+            id_type _dfa_alphabet = 0;
+        };
+
+        // The rows built so far. No graph means the DFA was built in full.
+        struct cache
+        {
+            std::shared_ptr<const graph> _graph;
+            node_vector_vector _seen_sets;
+            node_vector_vector _seen_vectors;
+            state_map _state_map;
+        };
+
+        lazy_dfa(const std::size_t size_, const std::size_t max_states_) :
+            _caches(size_),
+            _max_states(std::max(max_states_, static_cast<std::size_t>(1)))
+        {
+        }
+
+        bool lazy(const id_type dfa_index_) const override
+        {
+            return _caches[dfa_index_]._graph != nullptr;
+        }
+
+        bool any() const
+        {
+            for (const cache &cache_ : _caches)
+            {
+                if (cache_._graph) return true;
+            }
+
+            return false;
+        }
+
+        std::unique_ptr<detail::basic_lazy_dfa<id_type>> clone() const override
+        {
+            auto lazy_ = std::make_unique<lazy_dfa>(_caches.size(),
+                _max_states);
+
+            for (std::size_t i_ = 0, size_ = _caches.size(); i_ < size_; ++i_)
+            {
+                const cache &from_ = _caches[i_];
+                cache &to_ = lazy_->_caches[i_];
+
+                to_._graph = from_._graph;
+                copy(from_._seen_sets, to_._seen_sets);
+                copy(from_._seen_vectors, to_._seen_vectors);
+                to_._state_map = from_._state_map;
+            }
+
+            return lazy_;
+        }
+
+        void expand(const internals &internals_, const id_type dfa_index_,
+            const id_type state_) override
+        {
+            expand(_caches[dfa_index_], rows(internals_, dfa_index_), state_);
+        }
+
+        void trim(const internals &internals_, const id_type dfa_index_)
+            override
+        {
+            cache &cache_ = _caches[dfa_index_];
+
+            if (cache_._graph && cache_._seen_sets.size() > _max_states)
+            {
+                reset(cache_, rows(internals_, dfa_index_));
+            }
+        }
+
+        void complete(internals &internals_) override
+        {
+            for (std::size_t i_ = 0, size_ = _caches.size(); i_ < size_; ++i_)
+            {
+                cache &cache_ = _caches[i_];
+                id_type_vector &dfa_ = internals_._dfa[i_];
+                const std::size_t dfa_alphabet_ = internals_._dfa_alphabet[i_];
+
+                if (!cache_._graph ||
+                    dfa_alphabet_ == transitions_index) continue;
+
+                // Expanding appends rows, so re-read the size each time.
+                for (std::size_t state_ = 1;
+                    state_ * dfa_alphabet_ < dfa_.size(); ++state_)
+                {
+                    if (dfa_[state_ * dfa_alphabet_ + transitions_index] ==
+                        this->lazy_state())
+                    {
+                        expand(cache_, dfa_, static_cast<id_type>(state_));
+                    }
+                }
+            }
+        }
+
+        void init(const id_type dfa_index_, std::shared_ptr<const graph> graph_,
+            internals &internals_)
+        {
+            cache &cache_ = _caches[dfa_index_];
+
+            cache_._graph = std::move(graph_);
+            reset(cache_, internals_._dfa[dfa_index_]);
+        }
+
+    private:
+        std::vector<cache> _caches;
+        std::size_t _max_states;
+
+        // lookup() only has a const state machine, but the rows are
+        // just a cache of what the graph describes.
+        static id_type_vector &rows(const internals &internals_,
+            const id_type dfa_index_)
+        {
+            return const_cast<internals &>(internals_)._dfa[dfa_index_];
+        }
+
+        static void copy(const node_vector_vector &from_,
+            node_vector_vector &to_)
+        {
+            to_.reserve(from_.size());
+
+            for (const auto &vector_ : from_)
+            {
+                to_.emplace_back(std::make_unique<node_vector>(*vector_));
+            }
+        }
+
+        // Back to just the 'jam' state and the start state.
+        static void reset(cache &cache_, id_type_vector &dfa_)
+        {
+            cache_._seen_sets.clear();
+            cache_._seen_vectors.clear();
+            cache_._state_map.clear();
+            dfa_.assign(cache_._graph->_dfa_alphabet, 0);
+            add_state(cache_, cache_._graph->_followpos, dfa_);
+        }
+
+        // As closure(), but leaves the transitions of a new row to be
+        // built later.
+        static id_type add_state(cache &cache_, const node_vector &followpos_,
+            id_type_vector &dfa_)
+        {
+            const std::size_t size_ = dfa_.size();
+            const id_type index_ = closure(followpos_, cache_._seen_sets,
+                cache_._seen_vectors, cache_._state_map,
+                cache_._graph->_dfa_alphabet, dfa_);
+
+            if (dfa_.size() != size_)
+            {
+                check_rows(dfa_, cache_._graph->_dfa_alphabet);
+                std::fill(dfa_.begin() + size_ + transitions_index,
+                    dfa_.end(), detail::basic_lazy_dfa<id_type>::lazy_state());
+            }
+
+            return index_;
+        }
+
+        // The same as one pass of the loop in build_dfa().
+        static void expand(cache &cache_, id_type_vector &dfa_,
+            const id_type state_)
+        {
+            const graph &graph_ = *cache_._graph;
+            const std::size_t dfa_alphabet_ = graph_._dfa_alphabet;
+            equivset_list equiv_list_;
+
+            build_equiv_list(*cache_._seen_vectors[state_ - 1].get(),
+                graph_._set_mapping, equiv_list_, is_dfa());
+            std::fill(dfa_.begin() + state_ * dfa_alphabet_ +
+                transitions_index, dfa_.begin() + (state_ + 1) *
+                dfa_alphabet_, 0);
+
+            for (auto &equivset_ : equiv_list_)
+            {
+                const id_type transition_ = add_state(cache_,
+                    equivset_->_followpos, dfa_);
+
+                if (transition_ != sm_traits::npos())
+                {
+                    // add_state() may have reallocated the DFA.
+                    observer_ptr<id_type> ptr_ = &dfa_.front() +
+                        state_ * dfa_alphabet_;
+
+                    // Prune abstemious transitions from end states.
+                    if (*ptr_ && !equivset_->_greedy) continue;
+
+                    for (const id_type i_ : equivset_->_index_vector)
+                    {
+                        ptr_[i_ + transitions_index] = transition_;
+                    }
+                }
+            }
+        }
+    };
+
+    // As build_state(), but leaves the rows to lazy_. Lexer states that
+    // can't be built lazily are built in full.
+    static void build_lazy_state(const rules &rules_, const id_type index_,
+        lazy_dfa &lazy_, internals &internals_, sm &sm_)
+    {
+        auto graph_ = std::make_shared<typename lazy_dfa::graph>();
+        charset_map charset_map_;
+        id_type nl_id_ = sm_traits::npos();
+        observer_ptr<node> root_ = nullptr;
+
+        check_state(rules_, index_);
+        root_ = build_tree(rules_, index_, graph_->_node_ptr_vector,
+            charset_map_, nl_id_);
+
+        if (full_only(rules_, index_, nl_id_))
+        {
+            build_dfa(charset_map_, root_, internals_, sm_, index_, nl_id_,
+                ~static_cast<std::size_t>(0));
+            check_rows(internals_._dfa[index_],
+                internals_._dfa_alphabet[index_]);
+        }
+        else
+        {
+            charset_list charset_list_;
+            std::size_t dfa_alphabet_ = 0;
+
+            graph_->_set_mapping.resize(charset_map_.size());
+            partition_charsets(charset_map_, charset_list_, is_dfa());
+            build_set_mapping(charset_list_, internals_, index_,
+                graph_->_set_mapping);
+            dfa_alphabet_ = charset_list_.size() + transitions_index;
+
+            if (dfa_alphabet_ > sm_traits::npos())
+            {
+                // Overflow
+                throw runtime_error("The data type you have chosen "
+                    "cannot hold the dfa alphabet.");
+            }
+
+            graph_->_dfa_alphabet = static_cast<id_type>(dfa_alphabet_);
+            graph_->_followpos = root_->firstpos();
+            internals_._dfa_alphabet[index_] = graph_->_dfa_alphabet;
+            lazy_.init(index_, std::move(graph_), internals_);
+        }
+    }
+
+    // char_state_machine version
+    static void build_lazy(const rules &rules_, sm &sm_,
+        const std::size_t, const std::false_type &)
+    {
+        // The rows are appended to the state machine as they are built,
+        // so there is nothing to defer.
+        build(rules_, sm_);
+    }
+
+    // state_machine version
+    static void build_lazy(const rules &rules_, sm &sm_,
+        const std::size_t max_states_, const std::true_type &)
+    {
+        const std::size_t size_ = rules_.statemap().size();
+        // Strong exception guarantee
+        // http://www.boost.org/community/exception_safety.html
+        internals internals_;
+        sm temp_sm_;
+        auto lazy_ = std::make_unique<lazy_dfa>(size_, max_states_);
+
+        internals_._eoi = rules_.eoi();
+        internals_.add_states(size_);
+
+        for (id_type index_ = 0; index_ < size_; ++index_)
+        {
+            build_lazy_state(rules_, index_, *lazy_, internals_, temp_sm_);
+        }
+
+        if (lazy_->any())
+        {
+            internals_._lazy = std::move(lazy_);
+        }
+
+        create(internals_, temp_sm_, rules_, lookup());
+        sm_.swap(temp_sm_);
+    }
+
+    // Returns false as soon as the DFA has more than max_rows_ rows.
+    static bool build_dfa(const charset_map &charset_map_,
         const observer_ptr<node> root_, internals &internals_, sm &sm_,
-        const id_type dfa_index_, id_type &nl_id_)
+        const id_type dfa_index_, id_type &nl_id_,
+        const std::size_t max_rows_)
     {
         // partitioned charset list
         charset_list charset_list_;
         // vector mapping token indexes to partitioned token index sets
-        index_set_vector set_mapping_;
+        index_vector_vector set_mapping_;
         auto &dfa_ = internals_._dfa[dfa_index_];
         std::size_t dfa_alphabet_ = 0;
         const node_vector &followpos_ = root_->firstpos();
-        node_set_vector seen_sets_;
+        // Sorted positions of each DFA state, for equality tests
+        node_vector_vector seen_sets_;
+        // Positions of each DFA state in discovery order
         node_vector_vector seen_vectors_;
-        size_t_vector hash_vector_;
+        state_map state_map_;
         id_type zero_id_ = sm_traits::npos();
         id_type_set eol_set_;
 
@@ -206,7 +669,7 @@ protected:
         internals_._dfa_alphabet[dfa_index_] = dfa_alphabet_;
         // 'jam' state
         dfa_.resize(dfa_alphabet_, 0);
-        closure(followpos_, seen_sets_, seen_vectors_, hash_vector_,
+        closure(followpos_, seen_sets_, seen_vectors_, state_map_,
             dfa_alphabet_, dfa_);
 
         for (id_type index_ = 0; index_ < static_cast<id_type>
@@ -214,6 +677,8 @@ protected:
         {
             equivset_list equiv_list_;
 
+            if (seen_vectors_.size() > max_rows_) return false;
+
             build_equiv_list(*seen_vectors_[index_].get(), set_mapping_,
                 equiv_list_, is_dfa());
 
@@ -221,7 +686,7 @@ protected:
             {
                 const id_type transition_ = closure
                     (equivset_->_followpos, seen_sets_, seen_vectors_,
-                    hash_vector_, dfa_alphabet_, dfa_);
+                    state_map_, dfa_alphabet_, dfa_);
 
                 if (transition_ != sm_traits::npos())
                 {
@@ -254,6 +719,7 @@ protected:
         fix_clashes(eol_set_, nl_id_, zero_id_, dfa_, dfa_alphabet_,
             compressed());
         append_dfa(charset_list_, internals_, sm_, dfa_index_, lookup());
+        return true;
     }
 
     // Uncompressed
@@ -353,16 +819,18 @@ protected:
     }
 
     // char_state_machine version
-    static void create(internals &, sm &, const id_type_vector &,
+    static void create(internals &, sm &, const rules &,
         const std::false_type &)
     {
         // Nothing to do - will use append_dfa() instead
     }
 
     // state_machine version
-    static void create(internals &internals_, sm &sm_,
-        const id_type_vector &features_, const std::true_type &)
+    static void create(internals &internals_, sm &sm_, const rules &rules_,
+        const std::true_type &)
     {
+        const id_type_vector &features_ = rules_.features();
+
         for (std::size_t i_ = 0, size_ = internals_._dfa.size();
             i_ < size_; ++i_)
         {
@@ -375,6 +843,7 @@ protected:
         }
 
         sm_.data().swap(internals_);
+        sm_.keywords() = rules_.keywords();
     }
 
     // NFA version
@@ -421,14 +890,13 @@ protected:
                     }
                     else if ((*l_iter_)->empty())
                     {
-                        l_iter_->reset(overlap_.release());
-                        overlap_ = std::make_unique<charset>();
+                        // The emptied LHS becomes the next scratch overlap.
+                        l_iter_->swap(overlap_);
                         ++iter_;
                     }
                     else if (r_->empty())
                     {
-                        r_.reset(overlap_.release());
-                        overlap_ = std::make_unique<charset>();
+                        r_.swap(overlap_);
                         break;
                     }
                     else
@@ -460,7 +928,7 @@ protected:
 
     static void build_set_mapping(const charset_list &charset_list_,
         internals &internals_, const id_type dfa_index_,
-        index_set_vector &set_mapping_)
+        index_vector_vector &set_mapping_)
     {
         auto iter_ = charset_list_.cbegin();
         auto end_ = charset_list_.cend();
@@ -472,9 +940,10 @@ protected:
             fill_lookup(cs_->_token, &internals_._lookup[dfa_index_],
                 index_, lookup());
 
-            for (const id_type i_ : cs_->_index_set)
+            // index_ only ever increases, so each mapping stays sorted.
+            for (const id_type i_ : cs_->_index_vector)
             {
-                set_mapping_[i_].insert(index_);
+                set_mapping_[i_].push_back(index_);
             }
         }
     }
@@ -508,8 +977,8 @@ protected:
     }
 
     static id_type closure(const node_vector &followpos_,
-        node_set_vector &seen_sets_, node_vector_vector &seen_vectors_,
-        size_t_vector &hash_vector_, const id_type size_, id_type_vector &dfa_)
+        node_vector_vector &seen_sets_, node_vector_vector &seen_vectors_,
+        state_map &state_map_, const id_type size_, id_type_vector &dfa_)
     {
         bool end_state_ = false;
         id_type id_ = 0;
@@ -522,56 +991,82 @@ protected:
         if (followpos_.empty()) return sm_traits::npos();
 
         id_type index_ = 0;
-        std::unique_ptr<node_set> set_ptr_ = std::make_unique<node_set>();
+        std::unique_ptr<node_vector> set_ptr_ =
+            std::make_unique<node_vector>(followpos_);
         std::unique_ptr<node_vector> vector_ptr_ =
             std::make_unique<node_vector>();
 
-        for (observer_ptr<node> node_ : followpos_)
+        std::sort(set_ptr_->begin(), set_ptr_->end());
+        set_ptr_->erase(std::unique(set_ptr_->begin(), set_ptr_->end()),
+            set_ptr_->end());
+
+        for (observer_ptr<node> node_ : *set_ptr_)
         {
-            closure_ex(node_, end_state_, id_, user_id_, next_dfa_,
-                push_dfa_, pop_dfa_, *set_ptr_.get(),
-                *vector_ptr_.get(), hash_);
+            hash_ += hash_node(node_);
         }
 
-        bool found_ = false;
-        auto hash_iter_ = hash_vector_.cbegin();
-        auto hash_end_ = hash_vector_.cend();
-        auto set_iter_ = seen_sets_.cbegin();
+        size_t_vector &states_ = state_map_[hash_];
 
-        for (; hash_iter_ != hash_end_; ++hash_iter_, ++set_iter_)
+        for (const std::size_t state_ : states_)
         {
-            found_ = *hash_iter_ == hash_ && *(*set_iter_) == *set_ptr_;
-            ++index_;
-
-            if (found_) break;
+            if (*seen_sets_[state_] == *set_ptr_)
+            {
+                // State 0 is the jam state...
+                return static_cast<id_type>(state_ + 1);
+            }
         }
 
-        if (!found_)
+        if (set_ptr_->size() == followpos_.size())
         {
-            seen_sets_.emplace_back(std::move(set_ptr_));
-            seen_vectors_.emplace_back(std::move(vector_ptr_));
-            hash_vector_.push_back(hash_);
-            // State 0 is the jam state...
-            index_ = static_cast<id_type>(seen_sets_.size());
-
-            const std::size_t old_size_ = dfa_.size();
-
-            dfa_.resize(old_size_ + size_, 0);
+            vector_ptr_->assign(followpos_.begin(), followpos_.end());
+        }
+        else
+        {
+            // Drop duplicates but keep the first occurrence order.
+            std::vector<bool> seen_(set_ptr_->size(), false);
 
-            if (end_state_)
+            for (observer_ptr<node> node_ : followpos_)
             {
-                dfa_[old_size_] |= end_state_bit;
+                const std::size_t pos_ = std::lower_bound(set_ptr_->begin(),
+                    set_ptr_->end(), node_) - set_ptr_->begin();
 
-                if (pop_dfa_)
+                if (!seen_[pos_])
                 {
-                    dfa_[old_size_] |= pop_dfa_bit;
+                    seen_[pos_] = true;
+                    vector_ptr_->push_back(node_);
                 }
+            }
+        }
+
+        for (observer_ptr<node> node_ : *vector_ptr_)
+        {
+            closure_ex(node_, end_state_, id_, user_id_, next_dfa_,
+                push_dfa_, pop_dfa_);
+        }
 
-                dfa_[old_size_ + id_index] = id_;
-                dfa_[old_size_ + user_id_index] = user_id_;
-                dfa_[old_size_ + push_dfa_index] = push_dfa_;
-                dfa_[old_size_ + next_dfa_index] = next_dfa_;
+        states_.push_back(seen_sets_.size());
+        seen_sets_.emplace_back(std::move(set_ptr_));
+        seen_vectors_.emplace_back(std::move(vector_ptr_));
+        // State 0 is the jam state...
+        index_ = static_cast<id_type>(seen_sets_.size());
+
+        const std::size_t old_size_ = dfa_.size();
+
+        dfa_.resize(old_size_ + size_, 0);
+
+        if (end_state_)
+        {
+            dfa_[old_size_] |= end_state_bit;
+
+            if (pop_dfa_)
+            {
+                dfa_[old_size_] |= pop_dfa_bit;
             }
+
+            dfa_[old_size_ + id_index] = id_;
+            dfa_[old_size_ + user_id_index] = user_id_;
+            dfa_[old_size_ + push_dfa_index] = push_dfa_;
+            dfa_[old_size_ + next_dfa_index] = next_dfa_;
         }
 
         return index_;
@@ -579,8 +1074,7 @@ protected:
 
     static void closure_ex(observer_ptr<node> node_, bool &end_state_,
         id_type &id_, id_type &user_id_, id_type &next_dfa_,
-        id_type &push_dfa_, bool &pop_dfa_, node_set &set_ptr_,
-        node_vector &vector_ptr_, std::size_t &hash_)
+        id_type &push_dfa_, bool &pop_dfa_)
     {
         const bool temp_end_state_ = node_->end_state();
 
@@ -596,17 +1090,22 @@ protected:
                 pop_dfa_ = node_->pop_dfa();
             }
         }
+    }
 
-        if (set_ptr_.insert(node_).second)
-        {
-            vector_ptr_.push_back(node_);
-            hash_ += reinterpret_cast<std::size_t>(node_);
-        }
+    // Order independent, so it is summed over the set. Node addresses
+    // share their low bits, so mix them first.
+    static std::size_t hash_node(observer_ptr<const node> node_)
+    {
+        std::size_t hash_ = reinterpret_cast<std::size_t>(node_);
+
+        hash_ ^= hash_ >> 17;
+        hash_ *= static_cast<std::size_t>(0x9e3779b97f4a7c15ULL);
+        return hash_ ^ (hash_ >> 29);
     }
 
     // NFA version
     static void build_equiv_list(const node_vector &vector_,
-        const index_set_vector &set_mapping_, equivset_list &lhs_,
+        const index_vector_vector &set_mapping_, equivset_list &lhs_,
         const std::false_type &)
     {
         fill_rhs_list(vector_, set_mapping_, lhs_);
@@ -614,7 +1113,7 @@ protected:
 
     // DFA version
     static void build_equiv_list(const node_vector &vector_,
-        const index_set_vector &set_mapping_, equivset_list &lhs_,
+        const index_vector_vector &set_mapping_, equivset_list &lhs_,
         const std::true_type &)
     {
         equivset_list rhs_;
@@ -650,14 +1149,13 @@ protected:
                     }
                     else if ((*l_iter_)->empty())
                     {
-                        l_iter_->reset(overlap_.release());
-                        overlap_ = std::make_unique<equivset>();
+                        // The emptied LHS becomes the next scratch overlap.
+                        l_iter_->swap(overlap_);
                         ++iter_;
                     }
                     else if (r_->empty())
                     {
-                        r_.reset(overlap_.release());
-                        overlap_ = std::make_unique<equivset>();
+                        r_.swap(overlap_);
                         break;
                     }
                     else
@@ -679,7 +1177,7 @@ protected:
     }
 
     static void fill_rhs_list(const node_vector &vector_,
-        const index_set_vector &set_mapping_, equivset_list &list_)
+        const index_vector_vector &set_mapping_, equivset_list &list_)
     {
         for (observer_ptr<const node> node_ : vector_)
         {
@@ -692,11 +1190,10 @@ protected:
                     if (token_ == parser::bol_token() ||
                         token_ == parser::eol_token())
                     {
-                        std::set<id_type> index_set_;
+                        const index_vector index_vector_(1, token_);
 
-                        index_set_.insert(token_);
                         list_.emplace_back
-                            (std::make_unique<equivset>(index_set_,
+                            (std::make_unique<equivset>(index_vector_,
                                 token_, node_->greedy(), node_->followpos()));
                     }
                     else
@@ -14,6 +14,42 @@ namespace lexertl
 {
 namespace detail
 {
+template<typename id_type>
+struct basic_internals;
+
+// Builds the rows of DFAs made by basic_generator::build_lazy() as
+// lookup() first reaches them. Every transition of a row that has not
+// been built yet holds lazy_state().
+template<typename id_type>
+class basic_lazy_dfa
+{
+public:
+    using internals = basic_internals<id_type>;
+
+    virtual ~basic_lazy_dfa()
+    {
+    }
+
+    virtual std::unique_ptr<basic_lazy_dfa> clone() const = 0;
+    // Whether DFA dfa_ is built lazily. The others are complete.
+    virtual bool lazy(const id_type dfa_) const = 0;
+    // Fill in the transitions of row state_ of DFA dfa_. This may
+    // append rows to the DFA. The rows are only a cache, so this works
+    // on a const state machine.
+    virtual void expand(const internals &internals_, const id_type dfa_,
+        const id_type state_) = 0;
+    // Called between tokens: drops the rows of DFA dfa_ if it holds
+    // more than the cache allows.
+    virtual void trim(const internals &internals_, const id_type dfa_) = 0;
+    // Build every row that is still missing.
+    virtual void complete(internals &internals_) = 0;
+
+    static id_type lazy_state()
+    {
+        return ~static_cast<id_type>(0);
+    }
+};
+
 template<typename id_type>
 struct basic_internals
 {
@@ -25,16 +61,41 @@ struct basic_internals
     id_type_vector _dfa_alphabet;
     id_type _features;
     id_type_vector_vector _dfa;
+    // Only set for lazily built DFAs
+    std::unique_ptr<basic_lazy_dfa<id_type>> _lazy;
 
     basic_internals() :
         _eoi(0),
         _lookup(),
         _dfa_alphabet(),
         _features(0),
-        _dfa()
+        _dfa(),
+        _lazy()
+    {
+    }
+
+    basic_internals(const basic_internals &rhs_) :
+        _eoi(rhs_._eoi),
+        _lookup(rhs_._lookup),
+        _dfa_alphabet(rhs_._dfa_alphabet),
+        _features(rhs_._features),
+        _dfa(rhs_._dfa),
+        _lazy(rhs_._lazy ? rhs_._lazy->clone() : nullptr)
     {
     }
 
+    basic_internals(basic_internals &&) = default;
+
+    basic_internals &operator =(const basic_internals &rhs_)
+    {
+        basic_internals temp_(rhs_);
+
+        swap(temp_);
+        return *this;
+    }
+
+    basic_internals &operator =(basic_internals &&) = default;
+
     void clear()
     {
         _eoi = 0;
@@ -42,6 +103,7 @@ struct basic_internals
         _dfa_alphabet.clear();
         _features = 0;
         _dfa.clear();
+        _lazy.reset();
     }
 
     bool empty() const
@@ -67,6 +129,7 @@ struct basic_internals
         _dfa_alphabet.swap(internals_._dfa_alphabet);
         std::swap(_features, internals_._features);
         _dfa.swap(internals_._dfa);
+        _lazy.swap(internals_._lazy);
     }
 };
 }
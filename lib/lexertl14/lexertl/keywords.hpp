@@ -0,0 +1,393 @@
+// keywords.hpp
+// Copyright (c) 2026 The parle contributors. Not part of upstream lexertl.
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file licence_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+#ifndef LEXERTL_KEYWORDS_HPP
+#define LEXERTL_KEYWORDS_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include "narrow.hpp"
+#include "runtime_error.hpp"
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace lexertl
+{
+// Perfect hash table of keywords. lookup() gives a token matched by the
+// rule id() the id of the keyword it spells, so that a single identifier
+// rule in the DFA stands in for any number of keyword rules.
+//
+// The table is built by hash and displace: the keywords are spread over
+// buckets by hash, then, largest bucket first, each bucket gets the
+// first displacement that moves all of its keywords to free slots. A
+// lookup hashes the token once and compares it with one keyword at most.
+template<typename char_type, typename id_type>
+class basic_keywords
+{
+public:
+    using string = std::basic_string<char_type>;
+    using string_id_type_pair = std::pair<string, id_type>;
+    using keyword_vector = std::vector<string_id_type_pair>;
+
+    basic_keywords() :
+        _id(npos()),
+        _icase(false),
+        _size(0),
+        _max_size(0),
+        _displacements(),
+        _slots(),
+        _chars()
+    {
+    }
+
+    static id_type npos()
+    {
+        return ~static_cast<id_type>(0);
+    }
+
+    // Id of the rule whose matches are looked up, npos() if there is
+    // no table.
+    id_type id() const
+    {
+        return _id;
+    }
+
+    bool icase() const
+    {
+        return _icase;
+    }
+
+    // Number of keywords
+    std::size_t size() const
+    {
+        return _size;
+    }
+
+    // Number of slots in the table
+    std::size_t slots() const
+    {
+        return _slots.size();
+    }
+
+    bool empty() const
+    {
+        return _id == npos();
+    }
+
+    void clear()
+    {
+        _id = npos();
+        _icase = false;
+        _size = 0;
+        _max_size = 0;
+        _displacements.clear();
+        _slots.clear();
+        _chars.clear();
+    }
+
+    void swap(basic_keywords &rhs_)
+    {
+        std::swap(_id, rhs_._id);
+        std::swap(_icase, rhs_._icase);
+        std::swap(_size, rhs_._size);
+        std::swap(_max_size, rhs_._max_size);
+        _displacements.swap(rhs_._displacements);
+        _slots.swap(rhs_._slots);
+        _chars.swap(rhs_._chars);
+    }
+
+    // Replace the table. With icase_ set ASCII letters match
+    // regardless of case.
+    void build(const id_type id_, const keyword_vector &keywords_,
+        const bool icase_)
+    {
+        // Strong exception guarantee
+        basic_keywords temp_;
+        const std::size_t size_ = keywords_.size();
+        std::vector<string> keys_;
+        std::vector<std::uint64_t> hashes_;
+
+        if (size_ == 0)
+        {
+            clear();
+            return;
+        }
+
+        temp_._id = id_;
+        temp_._icase = icase_;
+        temp_._size = size_;
+        keys_.reserve(size_);
+        hashes_.reserve(size_);
+
+        for (const auto &pair_ : keywords_)
+        {
+            string key_ = pair_.first;
+
+            if (key_.empty())
+            {
+                throw runtime_error("Empty keyword.");
+            }
+
+            for (auto &c_ : key_)
+            {
+                c_ = temp_.fold(c_);
+            }
+
+            hashes_.push_back(hash(key_.begin(), key_.end()));
+            temp_._max_size = std::max(temp_._max_size, key_.size());
+            keys_.push_back(std::move(key_));
+        }
+
+        check_duplicates(keys_, hashes_);
+        temp_.place(keys_, hashes_, keywords_);
+        swap(temp_);
+    }
+
+    // Returns the id of the keyword in [first_, second_) or id_ if it
+    // is not a keyword.
+    template<typename iter_type>
+    id_type find(iter_type first_, const iter_type &second_,
+        const id_type id_) const
+    {
+        std::uint64_t hash_ = offset_basis;
+        std::size_t size_ = 0;
+
+        for (iter_type curr_ = first_; curr_ != second_; ++curr_)
+        {
+            // Too long to be a keyword
+            if (++size_ > _max_size) return id_;
+
+            hash_ = step(hash_, fold(*curr_));
+        }
+
+        if (size_ == 0) return id_;
+
+        const slot &slot_ = _slots[index(hash_,
+            _displacements[hash_ % _displacements.size()], _slots.size())];
+
+        if (slot_._size != size_) return id_;
+
+        const char_type *key_ = _chars.c_str() + slot_._offset;
+
+        for (; first_ != second_; ++first_, ++key_)
+        {
+            if (fold(*first_) != *key_) return id_;
+        }
+
+        return slot_._id;
+    }
+
+private:
+    struct slot
+    {
+        std::size_t _offset;
+        // 0 for a free slot
+        std::size_t _size;
+        id_type _id;
+    };
+
+    enum : std::uint64_t
+    {
+        offset_basis = 14695981039346656037ULL,
+        prime = 1099511628211ULL
+    };
+
+    id_type _id;
+    bool _icase;
+    std::size_t _size;
+    std::size_t _max_size;
+    std::vector<std::uint32_t> _displacements;
+    std::vector<slot> _slots;
+    // The keywords back to back, folded when _icase is set.
+    string _chars;
+
+    char_type fold(const char_type c_) const
+    {
+        return _icase && c_ >= 'A' && c_ <= 'Z' ?
+            static_cast<char_type>(c_ + ('a' - 'A')) : c_;
+    }
+
+    // FNV-1a
+    static std::uint64_t step(const std::uint64_t hash_, const char_type c_)
+    {
+        using unsigned_type = typename std::make_unsigned<char_type>::type;
+
+        return (hash_ ^ static_cast<unsigned_type>(c_)) * prime;
+    }
+
+    template<typename iter_type>
+    static std::uint64_t hash(iter_type first_, const iter_type &second_)
+    {
+        std::uint64_t hash_ = offset_basis;
+
+        for (; first_ != second_; ++first_)
+        {
+            hash_ = step(hash_, *first_);
+        }
+
+        return hash_;
+    }
+
+    static std::size_t index(std::uint64_t hash_,
+        const std::uint32_t displacement_, const std::size_t slots_)
+    {
+        // MurmurHash3 finaliser
+        hash_ += displacement_ * 0x9e3779b97f4a7c15ULL;
+        hash_ ^= hash_ >> 33;
+        hash_ *= 0xff51afd7ed558ccdULL;
+        hash_ ^= hash_ >> 33;
+        hash_ *= 0xc4ceb9fe1a85ec53ULL;
+        hash_ ^= hash_ >> 33;
+        return static_cast<std::size_t>(hash_ % slots_);
+    }
+
+    static void check_duplicates(const std::vector<string> &keys_,
+        const std::vector<std::uint64_t> &hashes_)
+    {
+        std::vector<std::size_t> order_(keys_.size());
+
+        for (std::size_t i_ = 0, size_ = order_.size(); i_ < size_; ++i_)
+        {
+            order_[i_] = i_;
+        }
+
+        std::sort(order_.begin(), order_.end(),
+            [&](const std::size_t lhs_, const std::size_t rhs_)
+            {
+                return hashes_[lhs_] < hashes_[rhs_] ||
+                    (hashes_[lhs_] == hashes_[rhs_] &&
+                    keys_[lhs_] < keys_[rhs_]);
+            });
+
+        for (std::size_t i_ = 1, size_ = order_.size(); i_ < size_; ++i_)
+        {
+            const string &key_ = keys_[order_[i_]];
+
+            if (hashes_[order_[i_ - 1]] == hashes_[order_[i_]] &&
+                keys_[order_[i_ - 1]] == key_)
+            {
+                std::ostringstream ss_;
+
+                ss_ << "Duplicate keyword '";
+                narrow(key_.c_str(), ss_);
+                ss_ << "'.";
+                throw runtime_error(ss_.str());
+            }
+        }
+    }
+
+    void place(const std::vector<string> &keys_,
+        const std::vector<std::uint64_t> &hashes_,
+        const keyword_vector &keywords_)
+    {
+        const std::size_t size_ = keys_.size();
+        // About four keywords per bucket and 80% of the slots in use.
+        const std::size_t buckets_ = size_ / 4 + 1;
+        std::size_t slots_ = size_ + size_ / 4 + 1;
+        std::vector<std::vector<std::size_t>> bucket_list_(buckets_);
+        std::vector<std::size_t> order_(buckets_);
+
+        for (std::size_t i_ = 0; i_ < size_; ++i_)
+        {
+            bucket_list_[hashes_[i_] % buckets_].push_back(i_);
+        }
+
+        for (std::size_t i_ = 0; i_ < buckets_; ++i_)
+        {
+            order_[i_] = i_;
+        }
+
+        std::stable_sort(order_.begin(), order_.end(),
+            [&](const std::size_t lhs_, const std::size_t rhs_)
+            {
+                return bucket_list_[lhs_].size() >
+                    bucket_list_[rhs_].size();
+            });
+
+        // Give up on a table size after this many displacements of a
+        // bucket and try a larger table.
+        while (!place(hashes_, bucket_list_, order_, slots_,
+            static_cast<std::uint32_t>(std::min<std::size_t>
+            (slots_ * 8, 0xffffffff))))
+        {
+            if (slots_ > size_ * 4 + 64)
+            {
+                throw runtime_error("Unable to build the keyword table.");
+            }
+
+            slots_ += slots_ / 8 + 1;
+        }
+
+        for (std::size_t i_ = 0; i_ < size_; ++i_)
+        {
+            const std::size_t bucket_ = hashes_[i_] % buckets_;
+            slot &slot_ = _slots[index(hashes_[i_],
+                _displacements[bucket_], slots_)];
+
+            slot_._offset = _chars.size();
+            slot_._size = keys_[i_].size();
+            slot_._id = keywords_[i_].second;
+            _chars += keys_[i_];
+        }
+    }
+
+    bool place(const std::vector<std::uint64_t> &hashes_,
+        const std::vector<std::vector<std::size_t>> &bucket_list_,
+        const std::vector<std::size_t> &order_, const std::size_t slots_,
+        const std::uint32_t tries_)
+    {
+        std::vector<bool> taken_(slots_, false);
+        std::vector<std::size_t> indexes_;
+
+        _displacements.assign(bucket_list_.size(), 0);
+        _slots.assign(slots_, slot{0, 0, npos()});
+
+        for (const std::size_t bucket_ : order_)
+        {
+            const auto &list_ = bucket_list_[bucket_];
+            std::uint32_t displacement_ = 0;
+
+            if (list_.empty()) break;
+
+            for (;;)
+            {
+                indexes_.clear();
+
+                for (const std::size_t key_ : list_)
+                {
+                    const std::size_t index_ =
+                        index(hashes_[key_], displacement_, slots_);
+
+                    if (taken_[index_] ||
+                        std::find(indexes_.begin(), indexes_.end(),
+                        index_) != indexes_.end())
+                    {
+                        break;
+                    }
+
+                    indexes_.push_back(index_);
+                }
+
+                if (indexes_.size() == list_.size()) break;
+
+                if (++displacement_ == tries_) return false;
+            }
+
+            _displacements[bucket_] = displacement_;
+
+            for (const std::size_t index_ : indexes_)
+            {
+                taken_[index_] = true;
+            }
+        }
+
+        return true;
+    }
+};
+}
+
+#endif
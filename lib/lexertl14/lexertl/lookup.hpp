@@ -92,6 +92,28 @@ struct recursive_state<id_type, true>
     }
 };
 
+template<typename id_type, bool>
+struct lazy_state
+{
+    lazy_state(const basic_internals<id_type> &, const id_type)
+    {
+    }
+};
+
+template<typename id_type>
+struct lazy_state<id_type, true>
+{
+    const basic_internals<id_type> &_internals;
+    id_type _dfa_index;
+
+    lazy_state(const basic_internals<id_type> &internals_,
+        const id_type state_) :
+        _internals(internals_),
+        _dfa_index(state_)
+    {
+    }
+};
+
 template<typename id_type, typename index_type, std::size_t flags>
 struct lookup_state
 {
@@ -109,6 +131,7 @@ struct lookup_state
     multi_state_state<id_type, (flags & multi_state_bit) != 0>
         _multi_state_state;
     recursive_state<id_type, (flags & recursive_bit) != 0> _recursive_state;
+    lazy_state<id_type, (flags & lazy_bit) != 0> _lazy_state;
 
     lookup_state(const internals &internals_, const bool bol_,
         const id_type state_) :
@@ -122,7 +145,8 @@ struct lookup_state
         _bol_state(bol_),
         _eol_state(),
         _multi_state_state(state_),
-        _recursive_state(_ptr)
+        _recursive_state(_ptr),
+        _lazy_state(internals_, state_)
     {
     }
 
@@ -177,11 +201,34 @@ struct lookup_state
         return ret_;
     }
 
+    id_type transition(const id_type index_, const std::false_type &)
+    {
+        return _ptr[index_];
+    }
+
+    id_type transition(const id_type index_, const std::true_type &)
+    {
+        if (_ptr[index_] == basic_lazy_dfa<id_type>::lazy_state())
+        {
+            const auto &internals_ = _lazy_state._internals;
+            const std::size_t row_ = (_ptr - _dfa) / _dfa_alphabet;
+
+            internals_._lazy->expand(internals_, _lazy_state._dfa_index,
+                static_cast<id_type>(row_));
+            // The DFA may have been reallocated.
+            _dfa = &internals_._dfa[_lazy_state._dfa_index].front();
+            _ptr = _dfa + row_ * _dfa_alphabet;
+        }
+
+        return _ptr[index_];
+    }
+
     template<typename char_type>
     id_type next_char(const char_type prev_char_, const std::false_type &)
     {
-        const id_type state_= _ptr[_lookup
-            [static_cast<index_type>(prev_char_)]];
+        const id_type state_= transition(_lookup
+            [static_cast<index_type>(prev_char_)],
+            std::integral_constant<bool, (flags & lazy_bit) != 0>());
 
         if (state_ != 0)
         {
@@ -201,8 +248,9 @@ struct lookup_state
 
         for (std::size_t i_ = 0; i_ < bytes_; ++i_)
         {
-            state_ = _ptr[_lookup[static_cast<unsigned char>((prev_char_ >>
-                shift_[bytes_ - 1 - i_]) & 0xff)]];
+            state_ = transition(_lookup[static_cast<unsigned char>
+                ((prev_char_ >> shift_[bytes_ - 1 - i_]) & 0xff)],
+                std::integral_constant<bool, (flags & lazy_bit) != 0>());
 
             if (state_ == 0)
             {
@@ -354,6 +402,20 @@ struct lookup_state
     }
 };
 
+template<typename id_type>
+void trim(const basic_internals<id_type> &, const id_type,
+    const std::false_type &)
+{
+    // Do nothing
+}
+
+template<typename id_type>
+void trim(const basic_internals<id_type> &internals_, const id_type state_,
+    const std::true_type &)
+{
+    internals_._lazy->trim(internals_, state_);
+}
+
 template<typename results>
 void inc_end(results &, const std::false_type &)
 {
@@ -390,6 +452,10 @@ again:
         return;
     }
 
+    // No row is in use between tokens, so the cache can be flushed.
+    trim(internals_, results_.state,
+        std::integral_constant<bool, (flags & lazy_bit) != 0>());
+
     lookup_state<id_type, typename results::index_type, flags> lu_state_
         (internals_, results_.bol, results_.state);
     lu_state_.bol_start_state
@@ -433,6 +499,12 @@ again:
             std::integral_constant<bool, (flags & bol_bit) != 0>());
         results_.second = end_token_;
 
+        if (lu_state_._id == sm_.keywords().id())
+        {
+            lu_state_._id = sm_.keywords().find(results_.first, end_token_,
+                lu_state_._id);
+        }
+
         if (lu_state_._id == sm_.skip()) goto skip;
 
         if (lu_state_.is_id_eoi(internals_._eoi, results_, recursive_))
@@ -470,9 +542,19 @@ void lookup(const basic_state_machine<typename std::iterator_traits
     // flags, or you should be using recursive_match_results instead
     // of match_results.
     assert((sm_.data()._features & flags) == sm_.data()._features);
-    detail::next<iter_type, flags, id_type>(sm_, results_,
-        std::integral_constant<bool, (sizeof(value_type) > 1)>(),
-        std::false_type(), cat());
+
+    if (sm_.data()._lazy)
+    {
+        detail::next<iter_type, flags | lazy_bit, id_type>(sm_, results_,
+            std::integral_constant<bool, (sizeof(value_type) > 1)>(),
+            std::false_type(), cat());
+    }
+    else
+    {
+        detail::next<iter_type, flags, id_type>(sm_, results_,
+            std::integral_constant<bool, (sizeof(value_type) > 1)>(),
+            std::false_type(), cat());
+    }
 }
 
 template<typename iter_type, typename id_type, std::size_t flags>
@@ -485,9 +567,20 @@ void lookup(const basic_state_machine<typename std::iterator_traits
 
     // If this asserts, you have not defined all the correct flags
     assert((sm_.data()._features & flags) == sm_.data()._features);
-    detail::next<iter_type, flags | recursive_bit, id_type>(sm_, results_,
-        std::integral_constant<bool, (sizeof(value_type) > 1)>(),
-        std::true_type(), cat());
+
+    if (sm_.data()._lazy)
+    {
+        detail::next<iter_type, flags | recursive_bit | lazy_bit, id_type>
+            (sm_, results_,
+            std::integral_constant<bool, (sizeof(value_type) > 1)>(),
+            std::true_type(), cat());
+    }
+    else
+    {
+        detail::next<iter_type, flags | recursive_bit, id_type>(sm_, results_,
+            std::integral_constant<bool, (sizeof(value_type) > 1)>(),
+            std::true_type(), cat());
+    }
 }
 }
 
@@ -9,7 +9,7 @@
 
 #include <algorithm>
 #include <iterator>
-#include <set>
+#include <vector>
 #include "../string_token.hpp"
 
 namespace lexertl
@@ -20,27 +20,27 @@ template<typename char_type, typename id_type>
 struct basic_charset
 {
     using token = basic_string_token<char_type>;
-    using index_set = std::set<id_type>;
+    // Sorted, unique
+    using index_vector = std::vector<id_type>;
 
     token _token;
-    index_set _index_set;
+    index_vector _index_vector;
 
     basic_charset() :
         _token(),
-        _index_set()
+        _index_vector()
     {
     }
 
     basic_charset(const token &token_, const std::size_t index_) :
         _token(token_),
-        _index_set()
+        _index_vector(1, static_cast<id_type>(index_))
     {
-        _index_set.insert(index_);
     }
 
     bool empty() const
     {
-        return _token.empty() && _index_set.empty();
+        return _token.empty() && _index_vector.empty();
     }
 
     void intersect(basic_charset &rhs_, basic_charset &overlap_)
@@ -49,19 +49,19 @@ struct basic_charset
 
         if (!overlap_._token.empty())
         {
-            std::merge(_index_set.begin(), _index_set.end(),
-                rhs_._index_set.begin(), rhs_._index_set.end(),
-                std::inserter(overlap_._index_set,
-                overlap_._index_set.end()));
+            overlap_._index_vector.clear();
+            std::set_union(_index_vector.begin(), _index_vector.end(),
+                rhs_._index_vector.begin(), rhs_._index_vector.end(),
+                std::back_inserter(overlap_._index_vector));
 
             if (_token.empty())
             {
-                _index_set.clear();
+                _index_vector.clear();
             }
 
             if (rhs_._token.empty())
             {
-                rhs_._index_set.clear();
+                rhs_._index_vector.clear();
             }
         }
     }
@@ -8,7 +8,7 @@
 
 #include <algorithm>
 #include "../parser/tree/node.hpp"
-#include <set>
+#include <vector>
 
 namespace lexertl
 {
@@ -17,7 +17,6 @@ namespace detail
 template<typename id_type>
 struct basic_equivset
 {
-    using index_set = std::set<id_type>;
     using index_vector = std::vector<id_type>;
     using node = basic_node<id_type>;
     using node_vector = std::vector<observer_ptr<node>>;
@@ -35,9 +34,9 @@ struct basic_equivset
     {
     }
 
-    basic_equivset(const index_set &index_set_, const id_type id_,
+    basic_equivset(const index_vector &index_vector_, const id_type id_,
         const bool greedy_, const node_vector &followpos_) :
-        _index_vector(index_set_.begin(), index_set_.end()),
+        _index_vector(index_vector_),
         _id(id_),
         _greedy(greedy_),
         _followpos(followpos_)
@@ -59,7 +58,18 @@ struct basic_equivset
             // respect rule ordering priority in the lex spec.
             overlap_._id = _id;
             overlap_._greedy = _greedy;
-            overlap_._followpos = _followpos;
+
+            // A fully consumed LHS is about to be discarded, so hand its
+            // followpos over rather than copying it.
+            if (_index_vector.empty())
+            {
+                overlap_._followpos.clear();
+                overlap_._followpos.swap(_followpos);
+            }
+            else
+            {
+                overlap_._followpos = _followpos;
+            }
 
             auto overlap_begin_ = overlap_._followpos.cbegin();
             auto overlap_end_ = overlap_._followpos.cend();
@@ -88,12 +98,36 @@ struct basic_equivset
     }
 
 private:
+    // Both vectors are sorted. Move the common indexes to overlap_ in a
+    // single pass rather than erasing them one at a time.
     void intersect_indexes(index_vector &rhs_, index_vector &overlap_)
     {
-        auto iter_ = _index_vector.begin();
-        auto end_ = _index_vector.end();
-        auto rhs_iter_ = rhs_.begin();
-        auto rhs_end_ = rhs_.end();
+        index_vector lhs_out_;
+        index_vector rhs_out_;
+        auto iter_ = _index_vector.cbegin();
+        auto end_ = _index_vector.cend();
+        auto rhs_iter_ = rhs_.cbegin();
+        auto rhs_end_ = rhs_.cend();
+
+        // Most pairs are disjoint, so skip ahead to the first common
+        // index before allocating anything.
+        while (iter_ != end_ && rhs_iter_ != rhs_end_ &&
+            *iter_ != *rhs_iter_)
+        {
+            if (*iter_ < *rhs_iter_)
+            {
+                ++iter_;
+            }
+            else
+            {
+                ++rhs_iter_;
+            }
+        }
+
+        if (iter_ == end_ || rhs_iter_ == rhs_end_) return;
+
+        lhs_out_.assign(_index_vector.cbegin(), iter_);
+        rhs_out_.assign(rhs_.cbegin(), rhs_iter_);
 
         while (iter_ != end_ && rhs_iter_ != rhs_end_)
         {
@@ -102,21 +136,26 @@ private:
 
             if (index_ < rhs_index_)
             {
+                lhs_out_.push_back(index_);
                 ++iter_;
             }
             else if (index_ > rhs_index_)
             {
+                rhs_out_.push_back(rhs_index_);
                 ++rhs_iter_;
             }
             else
             {
                 overlap_.push_back(index_);
-                iter_ = _index_vector.erase(iter_);
-                end_ = _index_vector.end();
-                rhs_iter_ = rhs_.erase(rhs_iter_);
-                rhs_end_ = rhs_.end();
+                ++iter_;
+                ++rhs_iter_;
             }
         }
+
+        lhs_out_.insert(lhs_out_.end(), iter_, end_);
+        rhs_out_.insert(rhs_out_.end(), rhs_iter_, rhs_end_);
+        _index_vector.swap(lhs_out_);
+        rhs_.swap(rhs_out_);
     }
 };
 }
@@ -7,6 +7,7 @@
 #define LEXERTL_RULES_HPP
 
 #include "enums.hpp"
+#include "keywords.hpp"
 #include <locale>
 #include <map>
 #include "narrow.hpp"
@@ -48,6 +49,8 @@ public:
     using macro_pair = std::pair<string, token_vector>;
     using tokeniser =
         detail::basic_re_tokeniser<rules_char_type, char_type, id_type>;
+    using keywords_type = basic_keywords<char_type, id_type>;
+    using keyword_vector = typename keywords_type::keyword_vector;
 
     // If you get a compile error here you have
     // failed to define an unsigned id type.
@@ -69,7 +72,8 @@ public:
         _pops(),
         _flags(flags_),
         _locale(),
-        _lexer_state_names()
+        _lexer_state_names(),
+        _keywords()
     {
         push_state(initial());
     }
@@ -92,6 +96,7 @@ public:
 #endif
         _locale = std::locale();
         _lexer_state_names.clear();
+        _keywords.clear();
         push_state(initial());
     }
 
@@ -346,6 +351,21 @@ public:
         push(curr_dfa_, regex_, id_, new_dfa_, true, user_id_);
     }
 
+    // Tokens matched by the rule id_ that spell one of keywords_ get
+    // the id of that keyword instead. Replaces any previous keywords.
+    void keywords(const id_type id_, const keyword_vector &keywords_,
+        const bool icase_ = false)
+    {
+        check_for_invalid_id(id_);
+
+        for (const auto &pair_ : keywords_)
+        {
+            check_for_invalid_id(pair_.second);
+        }
+
+        _keywords.build(id_, keywords_, icase_);
+    }
+
     void reverse()
     {
         for (auto &state_ : _regexes)
@@ -402,6 +422,11 @@ public:
         return _pops;
     }
 
+    const keywords_type &keywords() const
+    {
+        return _keywords;
+    }
+
     bool empty() const
     {
         bool empty_ = true;
@@ -453,6 +478,7 @@ private:
     std::size_t _flags;
     std::locale _locale;
     string_vector _lexer_state_names;
+    keywords_type _keywords;
 
     void tokenise(const string &regex_, token_vector &tokens_,
         const id_type id_, const rules_char_type *name_)
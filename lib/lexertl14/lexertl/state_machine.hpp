@@ -9,6 +9,7 @@
 // memcmp()
 #include <cstring>
 #include "internals.hpp"
+#include "keywords.hpp"
 #include <map>
 #include <set>
 #include "sm_traits.hpp"
@@ -24,19 +25,22 @@ public:
         basic_sm_traits<char_type, id_type,
             (sizeof(char_type) > 1), true, true>;
     using internals = detail::basic_internals<id_type>;
+    using keywords_type = basic_keywords<char_type, id_type>;
 
     // If you get a compile error here you have
     // failed to define an unsigned id type.
     static_assert(std::is_unsigned<id_type>::value, "Your id type is signed");
 
     basic_state_machine() :
-        _internals()
+        _internals(),
+        _keywords()
     {
     }
 
     void clear()
     {
         _internals.clear();
+        _keywords.clear();
     }
 
     internals &data()
@@ -49,6 +53,16 @@ public:
         return _internals;
     }
 
+    keywords_type &keywords()
+    {
+        return _keywords;
+    }
+
+    const keywords_type &keywords() const
+    {
+        return _keywords;
+    }
+
     bool empty() const
     {
         return _internals.empty();
@@ -59,8 +73,22 @@ public:
         return _internals._eoi;
     }
 
+    // Build the rows that a state machine from
+    // basic_generator::build_lazy() has not reached yet. Afterwards it
+    // behaves exactly like one built by basic_generator::build().
+    void complete()
+    {
+        if (_internals._lazy)
+        {
+            _internals._lazy->complete(_internals);
+            _internals._lazy.reset();
+        }
+    }
+
     void minimise()
     {
+        complete();
+
         const id_type dfas_ = static_cast<id_type>(_internals._dfa.size());
 
         for (id_type i_ = 0; i_ < dfas_; ++i_)
@@ -94,12 +122,14 @@ public:
     void swap(basic_state_machine &rhs_)
     {
         _internals.swap(rhs_._internals);
+        _keywords.swap(rhs_._keywords);
     }
 
 private:
     using id_type_vector = typename internals::id_type_vector;
     using index_set = std::set<id_type>;
     internals _internals;
+    keywords_type _keywords;
 
     void minimise_dfa(const id_type dfa_alphabet_,
         id_type_vector &dfa_, std::size_t size_)
@@ -369,6 +399,11 @@ struct basic_char_state_machine
         return _sm_vector.empty();
     }
 
+    void complete()
+    {
+        // Always built in full
+    }
+
     void minimise()
     {
         const id_type dfas_ = static_cast<id_type>(_sm_vector.size());
@@ -0,0 +1,116 @@
+// bitset.hpp
+// Copyright (c) 2026 The parle contributors. Not part of upstream parsertl.
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file licence_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+#ifndef PARSERTL_BITSET_HPP
+#define PARSERTL_BITSET_HPP
+
+#include <cassert>
+#include <climits>
+#include <cstddef>
+#include <vector>
+
+namespace parsertl
+{
+// Dynamically sized set of small integers (terminal ids, production
+// indexes) packed into machine words. The loops over whole words are
+// simple enough for the compiler to vectorise.
+class bitset
+{
+public:
+    using word = std::size_t;
+
+    enum {bits = sizeof(word) * CHAR_BIT};
+
+    bitset(const std::size_t size_ = 0) :
+        _size(size_),
+        _words((size_ + bits - 1) / bits, 0)
+    {
+    }
+
+    std::size_t size() const
+    {
+        return _size;
+    }
+
+    bool test(const std::size_t i_) const
+    {
+        assert(i_ < _size);
+        return (_words[i_ / bits] >> (i_ % bits)) & 1;
+    }
+
+    // Return true if i_ was not already in the set.
+    bool set(const std::size_t i_)
+    {
+        assert(i_ < _size);
+
+        word &w_ = _words[i_ / bits];
+        const word mask_ = static_cast<word>(1) << (i_ % bits);
+        const bool added_ = !(w_ & mask_);
+
+        w_ |= mask_;
+        return added_;
+    }
+
+    void reset(const std::size_t i_)
+    {
+        assert(i_ < _size);
+        _words[i_ / bits] &= ~(static_cast<word>(1) << (i_ % bits));
+    }
+
+    // Add every element of rhs_. Return true if the set changed.
+    bool merge(const bitset &rhs_)
+    {
+        const std::size_t size_ = _words.size();
+        word *lhs_ptr_ = _words.data();
+        const word *rhs_ptr_ = rhs_._words.data();
+        word changed_ = 0;
+
+        assert(_size == rhs_._size);
+
+        for (std::size_t i_ = 0; i_ < size_; ++i_)
+        {
+            changed_ |= rhs_ptr_[i_] & ~lhs_ptr_[i_];
+            lhs_ptr_[i_] |= rhs_ptr_[i_];
+        }
+
+        return changed_ != 0;
+    }
+
+    // Index of the first element >= i_, or size() if there is none.
+    std::size_t next(std::size_t i_) const
+    {
+        while (i_ < _size)
+        {
+            const word w_ = _words[i_ / bits] >> (i_ % bits);
+
+            if (w_ == 0)
+            {
+                i_ = (i_ / bits + 1) * bits;
+            }
+            else if (w_ & 1)
+            {
+                return i_;
+            }
+            else
+            {
+                ++i_;
+            }
+        }
+
+        return _size;
+    }
+
+    bool operator ==(const bitset &rhs_) const
+    {
+        return _size == rhs_._size && _words == rhs_._words;
+    }
+
+private:
+    std::size_t _size;
+    std::vector<word> _words;
+};
+}
+
+#endif
@@ -11,6 +11,7 @@
 #include "nt_info.hpp"
 #include "rules.hpp"
 #include "state_machine.hpp"
+#include <unordered_map>
 
 namespace parsertl
 {
@@ -63,7 +64,7 @@ public:
         rewrite(rules_, dfa_, new_grammar_, new_start_, new_nt_info_);
         build_first_sets(new_grammar_, new_nt_info_);
         // First add EOF to follow_set of start.
-        new_nt_info_[new_start_]._follow_set[0] = 1;
+        new_nt_info_[new_start_]._follow_set.set(0);
         build_follow_sets(new_grammar_, new_nt_info_);
         sm_.clear();
         build_table(rules_, dfa_, new_grammar_, new_nt_info_, sm_, warnings_);
@@ -78,8 +79,17 @@ public:
     {
         const grammar &grammar_ = rules_.grammar();
         const std::size_t terminals_ = rules_.tokens_info().size();
+        const std::size_t non_terminals_ = rules_.nt_locations().size();
         const std::size_t start_ = rules_.start();
         hash_map hash_map_;
+        // Scratch sets for closure(), cleared after each state.
+        bitset nt_set_(non_terminals_);
+        bitset prod_set_(grammar_.size());
+        // Successor kernels bucketed by symbol id; symbols_ records
+        // the order in which buckets were first used.
+        std::vector<size_t_pair_vector> item_sets_(terminals_ +
+            non_terminals_);
+        size_t_vector symbols_;
 
         dfa_.push_back(dfa_state());
 
@@ -103,57 +113,40 @@ public:
         for (std::size_t s_ = 0; s_ < dfa_.size(); ++s_)
         {
             dfa_state &state_ = dfa_[s_];
-            size_t_vector symbols_;
-            using item_sets = std::vector<size_t_pair_vector>;
-            item_sets item_sets_;
 
             state_._closure.assign(state_._basis.begin(), state_._basis.end());
-            closure(rules_, state_);
+            closure(rules_, state_, nt_set_, prod_set_);
+            symbols_.clear();
 
             for (const auto &pair_ : state_._closure)
             {
-                const production p_ = grammar_[pair_.first];
+                const production &p_ = grammar_[pair_.first];
 
                 if (pair_.second < p_._rhs.first.size())
                 {
                     const symbol &symbol_ = p_._rhs.first[pair_.second];
                     const std::size_t id_ = symbol_._type == symbol::TERMINAL ?
                         symbol_._id : terminals_ + symbol_._id;
-                    typename size_t_vector::const_iterator sym_iter_ =
-                        std::find(symbols_.begin(), symbols_.end(), id_);
-                    size_t_pair new_pair_(pair_.first, pair_.second + 1);
+                    size_t_pair_vector &vec_ = item_sets_[id_];
 
-                    if (sym_iter_ == symbols_.end())
+                    if (vec_.empty())
                     {
                         symbols_.push_back(id_);
-                        item_sets_.push_back(size_t_pair_vector());
-                        item_sets_.back().push_back(new_pair_);
                     }
-                    else
-                    {
-                        const std::size_t index_ =
-                            sym_iter_ - symbols_.begin();
-                        size_t_pair_vector &vec_ = item_sets_[index_];
-                        typename size_t_pair_vector::const_iterator i_ =
-                            std::find(vec_.begin(), vec_.end(), new_pair_);
 
-                        if (i_ == vec_.end())
-                        {
-                            vec_.push_back(new_pair_);
-                        }
-                    }
+                    // Closure items are unique, so are their successors.
+                    vec_.push_back(size_t_pair(pair_.first, pair_.second + 1));
                 }
             }
 
-            for (auto iter_ = symbols_.cbegin(), end_ = symbols_.cend();
-                iter_ != end_; ++iter_)
+            for (const std::size_t id_ : symbols_)
             {
-                std::size_t index_ = iter_ - symbols_.begin();
-                size_t_pair_vector &basis_ = item_sets_[index_];
+                size_t_pair_vector &basis_ = item_sets_[id_];
 
                 std::sort(basis_.begin(), basis_.end());
-                index_ = add_dfa_state(dfa_, hash_map_, basis_);
-                state_._transitions.push_back(size_t_pair(*iter_, index_));
+                state_._transitions.push_back(size_t_pair(id_,
+                    add_dfa_state(dfa_, hash_map_, basis_)));
+                basis_.clear();
             }
         }
     }
@@ -469,7 +462,7 @@ private:
     using entry = typename sm::entry;
     using grammar = typename rules::production_vector;
     using size_t_vector = std::vector<std::size_t>;
-    using hash_map = std::map<std::size_t, size_t_vector>;
+    using hash_map = std::unordered_map<std::size_t, size_t_vector>;
     using string_vector = typename rules::string_vector;
     using symbol = typename rules::symbol;
     using token_info = typename rules::token_info;
@@ -487,6 +480,17 @@ private:
         const std::size_t columns_ = terminals_ + non_terminals_;
         std::size_t index_ = 0;
 
+        // new_grammar_ indexes grouped by the state each rewritten
+        // production ends in.
+        std::vector<size_t_vector> reductions_(dfa_.size());
+
+        for (std::size_t i_ = 0, size_ = new_grammar_.size();
+            i_ < size_; ++i_)
+        {
+            reductions_[new_grammar_[i_]._rhs_indexes.back().second].
+                push_back(i_);
+        }
+
         rules_.symbols(symbols_);
         sm_._columns = columns_;
         sm_._rows = dfa_.size();
@@ -524,14 +528,15 @@ private:
 
                 if (production_._rhs.first.size() == c_.second)
                 {
-                    char_vector follow_set_(terminals_, 0);
+                    bitset follow_set_(terminals_);
 
                     // config is reduction
-                    for (const auto &p_ : new_grammar_)
+                    for (const std::size_t n_ : reductions_[index_])
                     {
+                        const prod &p_ = new_grammar_[n_];
+
                         if (production_._lhs == p_._production->_lhs &&
-                            production_._rhs == p_._production->_rhs &&
-                            index_ == p_._rhs_indexes.back().second)
+                            production_._rhs == p_._production->_rhs)
                         {
                             const std::size_t lhs_id_ = p_._lhs;
 
@@ -540,11 +545,10 @@ private:
                         }
                     }
 
-                    for (std::size_t i_ = 0, size_ = follow_set_.size();
-                        i_ < size_; ++i_)
+                    for (std::size_t i_ = follow_set_.next(0),
+                        size_ = follow_set_.size(); i_ < size_;
+                        i_ = follow_set_.next(i_ + 1))
                     {
-                        if (!follow_set_[i_]) continue;
-
                         entry &lhs_ = sm_._table[index_ * columns_ + i_];
                         entry rhs_(reduce, static_cast<id_type>
                             (production_._index));
@@ -596,43 +600,35 @@ private:
 
     // Add a new element to the set. Return true if the element was added
     // and false if it was already there.
-    static bool set_add(char_vector &s_, const std::size_t e_)
+    static bool set_add(bitset &s_, const std::size_t e_)
     {
-        const char rv_ = s_[e_];
-
-        assert(e_ < s_.size());
-        s_[e_] = 1;
-        return !rv_;
+        return s_.set(e_);
     }
 
     // Add every element of rhs_ to lhs_. Return true if lhs_ changes.
-    static bool set_union(char_vector &lhs_, const char_vector &rhs_)
+    static bool set_union(bitset &lhs_, const bitset &rhs_)
     {
-        const std::size_t size_ = lhs_.size();
-        bool progress_ = false;
-        char *lhs_ptr_ = &lhs_.front();
-        const char *rhs_ptr_ = &rhs_.front();
-
-        for (std::size_t i_ = 0; i_ < size_; i_++)
-        {
-            if (rhs_ptr_[i_] == 0) continue;
-
-            if (lhs_ptr_[i_] == 0)
-            {
-                progress_ = true;
-                lhs_ptr_[i_] = 1;
-            }
-        }
-
-        return progress_;
+        return lhs_.merge(rhs_);
     }
 
-    static void closure(const rules &rules_, dfa_state &state_)
+    // nt_set_ and prod_set_ must be empty on entry and are left that
+    // way on exit. A non-terminal is only ever expanded once, and
+    // prod_set_ catches dot 0 items that were already in the basis.
+    static void closure(const rules &rules_, dfa_state &state_,
+        bitset &nt_set_, bitset &prod_set_)
     {
         const typename rules::nt_location_vector &nt_locations_ =
             rules_.nt_locations();
         const grammar &grammar_ = rules_.grammar();
 
+        for (const auto &pair_ : state_._closure)
+        {
+            if (pair_.second == 0)
+            {
+                prod_set_.set(pair_.first);
+            }
+        }
+
         for (std::size_t c_ = 0; c_ < state_._closure.size(); ++c_)
         {
             const size_t_pair pair_ = state_._closure[c_];
@@ -644,25 +640,41 @@ private:
                 // SHIFT
                 const symbol &symbol_ = p_->_rhs.first[pair_.second];
 
-                if (symbol_._type == symbol::NON_TERMINAL)
+                if (symbol_._type == symbol::NON_TERMINAL &&
+                    set_add(nt_set_, symbol_._id))
                 {
                     for (std::size_t rule_ =
                         nt_locations_[symbol_._id]._first_production;
                         rule_ != npos(); rule_ = grammar_[rule_]._next_lhs)
                     {
-                        const size_t_pair new_pair_(rule_, 0);
-                        typename size_t_pair_vector::const_iterator i_ =
-                            std::find(state_._closure.begin(),
-                                state_._closure.end(), new_pair_);
-
-                        if (i_ == state_._closure.end())
+                        if (set_add(prod_set_, rule_))
                         {
-                            state_._closure.push_back(new_pair_);
+                            state_._closure.push_back(size_t_pair(rule_, 0));
                         }
                     }
                 }
             }
         }
+
+        for (const auto &pair_ : state_._closure)
+        {
+            const production &p_ = grammar_[pair_.first];
+
+            if (pair_.second == 0)
+            {
+                prod_set_.reset(pair_.first);
+            }
+
+            if (pair_.second < p_._rhs.first.size())
+            {
+                const symbol &symbol_ = p_._rhs.first[pair_.second];
+
+                if (symbol_._type == symbol::NON_TERMINAL)
+                {
+                    nt_set_.reset(symbol_._id);
+                }
+            }
+        }
     }
 
     static std::size_t add_dfa_state(dfa &dfa_, hash_map &hash_map_,
@@ -696,19 +708,25 @@ private:
         return index_;
     }
 
-    static std::size_t hash_set(size_t_pair_vector &vec_)
+    static std::size_t hash_set(const size_t_pair_vector &vec_)
     {
-        std::size_t hash_ = 0;
+        std::size_t hash_ = vec_.size();
 
         for (const auto &pair_ : vec_)
         {
-            hash_ *= 571;
-            hash_ += pair_.first * 37 + pair_.second;
+            hash_combine(hash_, pair_.first);
+            hash_combine(hash_, pair_.second);
         }
 
         return hash_;
     }
 
+    static void hash_combine(std::size_t &hash_, const std::size_t value_)
+    {
+        hash_ ^= std::hash<std::size_t>()(value_) + 0x9e3779b9 +
+            (hash_ << 6) + (hash_ >> 2);
+    }
+
     static void fill_entry(const rules &rules_,
         const size_t_pair_vector &config_, const string_vector &symbols_,
         entry &lhs_, const std::size_t id_, const entry &rhs_,
@@ -6,22 +6,21 @@
 #ifndef PARSERTL_NT_INFO_HPP
 #define PARSERTL_NT_INFO_HPP
 
+#include "bitset.hpp"
 #include <vector>
 
 namespace parsertl
 {
-using char_vector = std::vector<char>;
-
 struct nt_info
 {
     bool _nullable;
-    char_vector _first_set;
-    char_vector _follow_set;
+    bitset _first_set;
+    bitset _follow_set;
 
     nt_info(const std::size_t terminals_) :
         _nullable(false),
-        _first_set(terminals_, 0),
-        _follow_set(terminals_, 0)
+        _first_set(terminals_),
+        _follow_set(terminals_)
     {
     }
 };
@@ -36,6 +36,12 @@
 #define __STDC_FORMAT_MACROS
 #include "inttypes.h"
 
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
 #include "lexertl/generator.hpp"
 #include "lexertl/lookup.hpp"
 #include "lexertl/iterator.hpp"
@@ -52,6 +58,7 @@
 #include "php_ini.h"
 #include "ext/standard/info.h"
 #include "zend_exceptions.h"
+#include "zend_smart_str.h"
 #include "php_parle.h"
 
 #undef lookup
@@ -63,31 +70,479 @@ ZEND_DECLARE_MODULE_GLOBALS(parle)
 /* True global resources - no need for thread safety here */
 /* static int le_parle; */
 
+/* Fixed size set of worker threads for the batch methods. The jobs only
+	run lexertl/parsertl code on memory prepared by the PHP thread, they
+	never call into the engine. */
+class parle_thread_pool
+{/*{{{*/
+public:
+	explicit parle_thread_pool(size_t size) : stop(false)
+	{
+		for (size_t i = 0; i < size; i++) {
+			workers.emplace_back([this] { work(); });
+		}
+	}
+
+	~parle_thread_pool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mtx);
+			stop = true;
+		}
+		cv.notify_all();
+		for (auto &t : workers) {
+			t.join();
+		}
+	}
+
+	size_t size() const noexcept
+	{
+		return workers.size();
+	}
+
+	/* Call f(i) for each i < n on the workers and the calling thread,
+		return once all the calls are done. f must not throw. */
+	template<typename F> void run(size_t n, const F &f)
+	{
+		struct batch {
+			std::atomic<size_t> next{0};
+			size_t done = 0;
+			std::mutex mtx;
+			std::condition_variable cv;
+		};
+		auto b = std::make_shared<batch>();
+		/* A task can be picked up after the batch is complete, it then
+			holds the last reference but never touches f. */
+		auto task = [b, n, &f] {
+			size_t i, cnt = 0;
+
+			while ((i = b->next++) < n) {
+				f(i);
+				cnt++;
+			}
+			if (cnt) {
+				std::lock_guard<std::mutex> lock(b->mtx);
+				b->done += cnt;
+				if (b->done == n) {
+					b->cv.notify_one();
+				}
+			}
+		};
+
+		{
+			std::lock_guard<std::mutex> lock(mtx);
+			for (size_t i = 1; i < std::min(n, workers.size() + 1); i++) {
+				queue.emplace_back(task);
+			}
+		}
+		cv.notify_all();
+
+		task();
+
+		std::unique_lock<std::mutex> lock(b->mtx);
+		b->cv.wait(lock, [&b, n] { return b->done == n; });
+	}
+
+private:
+	void work()
+	{
+		while (true) {
+			std::function<void()> task;
+			{
+				std::unique_lock<std::mutex> lock(mtx);
+				cv.wait(lock, [this] { return stop || !queue.empty(); });
+				if (queue.empty()) {
+					return;
+				}
+				task = std::move(queue.front());
+				queue.pop_front();
+			}
+			task();
+		}
+	}
+
+	std::vector<std::thread> workers;
+	std::deque<std::function<void()>> queue;
+	std::mutex mtx;
+	std::condition_variable cv;
+	bool stop;
+};/*}}}*/
+
+static parle_thread_pool *parle_pool = nullptr;
+static std::mutex parle_pool_mtx;
+#ifndef PHP_WIN32
+static pid_t parle_pool_pid = 0;
+#endif
+
+/* Whether the pool was started in this process. A child forked after
+	that inherits the pool, but none of its threads. Waiting on them or
+	joining them would hang, so there the pool is dropped and leaked. */
+static bool
+php_parle_thread_pool_owned(void)
+{/*{{{*/
+#ifndef PHP_WIN32
+	return parle_pool_pid == getpid();
+#else
+	return true;
+#endif
+}/*}}}*/
+
+/* The pool is started on first use, so processes forked after MINIT
+	don't inherit a set of dead threads, and started again in a process
+	forked after that. The calling thread takes part in the work too,
+	hence one worker less than parle.threads. */
+static parle_thread_pool &
+php_parle_thread_pool(void)
+{/*{{{*/
+	std::lock_guard<std::mutex> lock(parle_pool_mtx);
+
+	if (parle_pool && !php_parle_thread_pool_owned()) {
+		parle_pool = nullptr;
+	}
+	if (!parle_pool) {
+		zend_long threads = INI_INT("parle.threads");
+
+		if (threads <= 0) {
+			threads = static_cast<zend_long>(std::max(std::thread::hardware_concurrency(), 1u));
+		}
+		parle_pool = new parle_thread_pool(static_cast<size_t>(threads - 1));
+#ifndef PHP_WIN32
+		parle_pool_pid = getpid();
+#endif
+	}
+
+	return *parle_pool;
+}/*}}}*/
+
+/* STL allocator on the Zend memory manager. What it holds counts against
+	memory_limit, shows in memory_get_usage() and is freed with the request
+	at the latest. It's only for the per object state used on the PHP
+	thread, the pool threads must not touch the Zend heap.
+
+	Zend MM bails out with a longjmp when it hits memory_limit, which
+	skips the destructors of the C++ frames in between and leaves the
+	containers being changed half done. So the limit is checked first
+	and std::bad_alloc thrown instead, with a chunk of slack for the bins.
+	Running out of system memory still bails out. Every container using
+	it must only grow inside a try block catching std::exception. */
+template<typename T> struct parle_allocator {/*{{{*/
+	using value_type = T;
+
+	parle_allocator() noexcept
+	{
+	}
+
+	template<typename U> parle_allocator(const parle_allocator<U> &) noexcept
+	{
+	}
+
+	T *allocate(size_t n)
+	{
+		size_t limit = static_cast<size_t>(PG(memory_limit)), used = zend_memory_usage(1) + ZEND_MM_CHUNK_SIZE;
+
+		if (n > SIZE_MAX / sizeof(T) || used > limit || n * sizeof(T) > limit - used) {
+			throw std::bad_alloc();
+		}
+		return static_cast<T *>(emalloc(n * sizeof(T)));
+	}
+
+	void deallocate(T *p, size_t) noexcept
+	{
+		efree(p);
+	}
+};/*}}}*/
+
+template<typename T, typename U> static zend_always_inline bool
+operator ==(const parle_allocator<T> &, const parle_allocator<U> &) noexcept
+{/*{{{*/
+	return true;
+}/*}}}*/
+
+template<typename T, typename U> static zend_always_inline bool
+operator !=(const parle_allocator<T> &, const parle_allocator<U> &) noexcept
+{/*{{{*/
+	return false;
+}/*}}}*/
+
+using parle_string = std::basic_string<char, std::char_traits<char>, parle_allocator<char>>;
+template<typename T> using parle_vector = std::vector<T, parle_allocator<T>>;
+template<typename T> using parle_deque = std::deque<T, parle_allocator<T>>;
+
+/* Match results and token iterator over a parle_string input. */
+using parle_smatch = lexertl::match_results<parle_string::const_iterator>;
+using parle_srmatch = lexertl::recursive_match_results<parle_string::const_iterator>;
+using parle_lexer_siterator = lexertl::iterator<parle_string::const_iterator, lexertl::state_machine, parle_smatch>;
+
+/* Set of token ids to drop from the token stream. Small ids are kept in
+	a bitmap, so the check in the advance loop is a single lookup. */
+struct parle_id_filter {/*{{{*/
+	std::vector<bool> bits;
+	std::set<size_t> rest;
+
+	void insert(size_t id)
+	{
+		if (id < 1024) {
+			if (id >= bits.size()) {
+				bits.resize(id + 1, false);
+			}
+			bits[id] = true;
+		} else {
+			rest.insert(id);
+		}
+	}
+
+	bool has(size_t id) const noexcept
+	{
+		if (id < bits.size()) {
+			return bits[id];
+		}
+		return !rest.empty() && rest.find(id) != rest.end();
+	}
+
+	bool operator ==(const parle_id_filter &other) const noexcept
+	{
+		return bits == other.bits && rest == other.rest;
+	}
+};/*}}}*/
+
+/* Wraps a lexertl iterator and steps over the tokens matched by a filter,
+	so the parser never sees them. */
+template<typename lexer_iterator>
+class parle_filter_iterator
+{/*{{{*/
+public:
+	using value_type = typename lexer_iterator::value_type;
+	using difference_type = typename lexer_iterator::difference_type;
+	using pointer = typename lexer_iterator::pointer;
+	using reference = typename lexer_iterator::reference;
+	using iterator_category = std::forward_iterator_tag;
+	using iter_type = typename value_type::iter_type;
+	using sm_type = lexertl::state_machine;
+
+	parle_filter_iterator(const iter_type &start, const iter_type &end, const sm_type &sm, const struct parle_id_filter *filter) :
+		_iter(start, end, sm),
+		_filter(filter)
+	{
+		skip();
+	}
+
+	parle_filter_iterator &operator ++()
+	{
+		++_iter;
+		skip();
+		return *this;
+	}
+
+	const value_type &operator *() const
+	{
+		return *_iter;
+	}
+
+	const value_type *operator ->() const
+	{
+		return &*_iter;
+	}
+
+private:
+	lexer_iterator _iter;
+	const struct parle_id_filter *_filter;
+
+	void skip()
+	{
+		if (!_filter) {
+			return;
+		}
+		while (_iter->first != _iter->eoi && _filter->has(_iter->id)) {
+			++_iter;
+		}
+	}
+};/*}}}*/
+
+using parle_siterator = parle_filter_iterator<parle_lexer_siterator>;
+using parle_citerator = parle_filter_iterator<lexertl::citerator>;
+
+/* Line starts in the input, scanned only as far as positions were asked
+	for. All offsets count from the start of the stream, input dropped by
+	feed() is folded into lines and line_start. */
+struct parle_line_index {/*{{{*/
+	size_t lines; /* Lines started in dropped input. */
+	size_t line_start; /* Start of the last of them. */
+	parle_vector<size_t> starts;
+	size_t scanned;
+};/*}}}*/
+
+/* Position where lexing can be resumed after an edit, see relex(). Of
+	results only bol, state and the RLexer stack are used. reach is how
+	far the tokens before offset looked into the input. */
+template<typename lexer_type>
+struct parle_lexer_checkpoint {/*{{{*/
+	size_t offset;
+	size_t reach;
+	lexer_type results;
+};/*}}}*/
+
+/* Rules and state machines are immutable once built. A lexer or parser
+	shares them with its clones and cursors, the last one to go frees them.
+	Anything still changing them afterwards has to separate first. */
+template<typename T> struct parle_shared : public T {/*{{{*/
+	uint32_t refcount;
+
+	parle_shared() : refcount(1)
+	{
+	}
+
+	explicit parle_shared(const T &t) : T(t), refcount(1)
+	{
+	}
+
+	parle_shared(const parle_shared &) = delete;
+};/*}}}*/
+
+using parle_lexer_rules = parle_shared<lexertl::rules>;
+using parle_lexer_sm = parle_shared<lexertl::state_machine>;
+using parle_parser_rules = parle_shared<parsertl::rules>;
+using parle_parser_sm = parle_shared<parsertl::state_machine>;
+
+template<typename T> static zend_always_inline parle_shared<T> *
+php_parle_shared_addref(parle_shared<T> *p) noexcept
+{/*{{{*/
+	p->refcount++;
+	return p;
+}/*}}}*/
+
+template<typename T> static zend_always_inline void
+php_parle_shared_release(parle_shared<T> *p) noexcept
+{/*{{{*/
+	if (p && 0 == --p->refcount) {
+		delete p;
+	}
+}/*}}}*/
+
+/* Make p private to the caller, copying it if it's shared. */
+template<typename T> static void
+php_parle_shared_separate(parle_shared<T> *&p)
+{/*{{{*/
+	if (p->refcount > 1) {
+		parle_shared<T> *copy = new parle_shared<T>(static_cast<const T &>(*p));
+
+		p->refcount--;
+		p = copy;
+	}
+}/*}}}*/
+
 struct ze_parle_lexer_obj {/*{{{*/
-	lexertl::rules *rules;
-	lexertl::state_machine *sm;
-	lexertl::smatch *results;
-	std::string *in;
+	parle_lexer_rules *rules;
+	parle_lexer_sm *sm;
+	parle_smatch *results;
+	parle_string *in;
+	struct parle_id_filter *filter;
+	size_t in_offset; /* Offset of in within the whole stream, see feed(). */
+	parle_smatch *in_state; /* Lexer state at the start of in if not the initial one. */
+	parle_vector<struct parle_lexer_checkpoint<parle_smatch>> *checkpoints;
+	parle_deque<parle_smatch> *lookahead; /* Tokens lexed by peek(). */
+	struct parle_line_index *lines;
 	bool complete;
 	zend_object zo;
 };/*}}}*/
 
 struct ze_parle_rlexer_obj {/*{{{*/
-	lexertl::rules *rules;
-	lexertl::state_machine *sm;
-	lexertl::srmatch *results;
-	std::string *in;
+	parle_lexer_rules *rules;
+	parle_lexer_sm *sm;
+	parle_srmatch *results;
+	parle_string *in;
+	struct parle_id_filter *filter;
+	size_t in_offset; /* Offset of in within the whole stream, see feed(). */
+	parle_srmatch *in_state; /* Lexer state at the start of in if not the initial one. */
+	parle_vector<struct parle_lexer_checkpoint<parle_srmatch>> *checkpoints;
+	parle_deque<parle_srmatch> *lookahead; /* Tokens lexed by peek(). */
+	struct parle_line_index *lines;
+	bool complete;
+	zend_object zo;
+};/*}}}*/
+
+/* A cursor over one input, sharing the state machine of the lexer it was
+	made by. The members it has in common with the lexer are named alike,
+	so the lexer method templates work on it. */
+struct ze_parle_lexer_cursor_obj {/*{{{*/
+	parle_lexer_sm *sm;
+	parle_smatch *results;
+	parle_string *in;
+	struct parle_id_filter *filter;
+	size_t in_offset; /* Always 0, the input is never dropped. */
+	parle_deque<parle_smatch> *lookahead;
+	struct parle_line_index *lines;
+	bool complete;
+	zend_object zo;
+};/*}}}*/
+
+struct ze_parle_rlexer_cursor_obj {/*{{{*/
+	parle_lexer_sm *sm;
+	parle_srmatch *results;
+	parle_string *in;
+	struct parle_id_filter *filter;
+	size_t in_offset; /* Always 0, the input is never dropped. */
+	parle_deque<parle_srmatch> *lookahead;
+	struct parle_line_index *lines;
 	bool complete;
 	zend_object zo;
 };/*}}}*/
 
+/* A token or reduced production in push mode, first and second are
+	offsets into parle_parser_push::buf. */
+struct parle_push_production {/*{{{*/
+	size_t id;
+	size_t first;
+	size_t second;
+};/*}}}*/
+
+/* State of a parser driven by Parser::pushToken(). Only the values still
+	referenced from the production stack are kept in buf. */
+struct parle_parser_push {/*{{{*/
+	parle_string buf;
+	size_t buf_offset; /* Offset of buf within all the pushed values. */
+	parle_vector<struct parle_push_production> productions;
+	struct parle_push_production token; /* Current lookahead. */
+	bool need_token;
+};/*}}}*/
+
+/* Parser state right after a token was shifted, see reparse(). */
+struct parle_parser_snapshot {/*{{{*/
+	struct parle_lexer_checkpoint<parle_smatch> lex;
+	parle_vector<size_t> stack;
+};/*}}}*/
+
+/* The document kept by Parser::reparse() with the snapshots of its last
+	parse. The lexer state machine and filter it was parsed with are
+	remembered, any other lexer means a full parse. The state machine is
+	referenced, so its address can't be taken by another one meanwhile. */
+struct parle_parser_reparse {/*{{{*/
+	parle_string in;
+	parle_vector<struct parle_parser_snapshot> snapshots;
+	parle_lexer_sm *lex_sm;
+	struct parle_id_filter *filter;
+	bool valid;
+
+	/* Owns lex_sm and filter, a copy would release them twice. */
+	parle_parser_reparse(const parle_parser_reparse &) = delete;
+	parle_parser_reparse &operator=(const parle_parser_reparse &) = delete;
+
+	~parle_parser_reparse()
+	{
+		php_parle_shared_release(lex_sm);
+		delete filter;
+	}
+};/*}}}*/
+
 struct ze_parle_parser_obj {/*{{{*/
-	parsertl::rules *rules;
-	parsertl::state_machine *sm;
+	parle_parser_rules *rules;
+	parle_parser_sm *sm;
 	parsertl::match_results *results;
-	std::string *in;
-	parsertl::token<lexertl::siterator>::token_vector *productions;
-	lexertl::siterator *iter;
+	parle_string *in;
+	parsertl::token<parle_siterator>::token_vector *productions;
+	parle_siterator *iter;
+	struct parle_id_filter *filter;
+	struct parle_parser_push *push;
+	struct parle_parser_reparse *reparse;
 	bool complete;
 	zend_object zo;
 };/*}}}*/
@@ -100,11 +555,15 @@ struct ze_parle_stack_obj {/*{{{*/
 /* {{{ Class entries and handlers declarations. */
 zend_object_handlers parle_lexer_handlers;
 zend_object_handlers parle_rlexer_handlers;
+zend_object_handlers parle_lexer_cursor_handlers;
+zend_object_handlers parle_rlexer_cursor_handlers;
 zend_object_handlers parle_parser_handlers;
 zend_object_handlers parle_stack_handlers;
 
 static zend_class_entry *ParleLexer_ce;
 static zend_class_entry *ParleRLexer_ce;
+static zend_class_entry *ParleLexerCursor_ce;
+static zend_class_entry *ParleRLexerCursor_ce;
 static zend_class_entry *ParleParser_ce;
 static zend_class_entry *ParleStack_ce;
 static zend_class_entry *ParleLexerException_ce;
@@ -143,6 +602,87 @@ php_parle_parser_stack_fetch_obj(zend_object *obj) noexcept
 	return (struct ze_parle_stack_obj *)((char *)obj - XtOffsetOf(struct ze_parle_stack_obj, zo));
 }/*}}}*/
 
+static void
+php_parle_token_init(zval *tok, zend_long id, const char *val, size_t val_len, zend_long offset) noexcept
+{/*{{{*/
+	object_init_ex(tok, ParleToken_ce);
+	add_property_long_ex(tok, "id", sizeof("id")-1, id);
+#if PHP_MAJOR_VERSION > 7 || PHP_MAJOR_VERSION >= 7 && PHP_MINOR_VERSION >= 2
+	add_property_stringl_ex(tok, "value", sizeof("value")-1, val, val_len);
+#else
+	add_property_stringl_ex(tok, "value", sizeof("value")-1, (char *)val, val_len);
+#endif
+	add_property_long(tok, "offset", offset);
+}/*}}}*/
+
+/* Record the line starts in in up to the stream offset upto. The input
+	begins at in_offset within the stream. */
+static void
+php_parle_line_index_scan(struct parle_line_index &idx, const char *in, size_t in_offset, size_t upto)
+{/*{{{*/
+	if (upto <= idx.scanned) {
+		return;
+	}
+
+	const char *p = in + (idx.scanned - in_offset), *end = in + (upto - in_offset);
+
+	/* memchr() is vectorized by the libc, much faster than a byte loop. */
+	while ((p = static_cast<const char *>(memchr(p, '\n', end - p)))) {
+		idx.starts.push_back(in_offset + (++p - in));
+	}
+	idx.scanned = upto;
+}/*}}}*/
+
+/* Fold the line starts up to the stream offset upto into the counters,
+	the input before it is about to be dropped. */
+static void
+php_parle_line_index_drop(struct parle_line_index &idx, const char *in, size_t in_offset, size_t upto)
+{/*{{{*/
+	php_parle_line_index_scan(idx, in, in_offset, upto);
+
+	auto it = std::upper_bound(idx.starts.begin(), idx.starts.end(), upto);
+
+	if (it != idx.starts.begin()) {
+		idx.lines += it - idx.starts.begin();
+		idx.line_start = *(it - 1);
+		idx.starts.erase(idx.starts.begin(), it);
+	}
+}/*}}}*/
+
+/* Forget the line starts from the stream offset from on, the input
+	there has changed. */
+static void
+php_parle_line_index_truncate(struct parle_line_index &idx, size_t from)
+{/*{{{*/
+	if (idx.scanned > from) {
+		idx.starts.erase(std::upper_bound(idx.starts.begin(), idx.starts.end(), from), idx.starts.end());
+		idx.scanned = from;
+	}
+}/*}}}*/
+
+/* Add the 1 based line and column of the stream offset to the token. */
+static void
+php_parle_token_position(zval *tok, struct parle_line_index &idx, const char *in, size_t in_offset, size_t offset)
+{/*{{{*/
+	php_parle_line_index_scan(idx, in, in_offset, offset);
+
+	auto it = std::upper_bound(idx.starts.begin(), idx.starts.end(), offset);
+	size_t line = idx.lines + (it - idx.starts.begin()) + 1;
+	size_t line_start = it != idx.starts.begin() ? *(it - 1) : idx.line_start;
+
+	add_property_long_ex(tok, "line", sizeof("line")-1, static_cast<zend_long>(line));
+	add_property_long_ex(tok, "column", sizeof("column")-1, static_cast<zend_long>(offset - line_start + 1));
+}/*}}}*/
+
+template<typename lexer_obj_type> static void
+php_parle_lexer_token_position(lexer_obj_type *zplo, zval *tok, size_t offset)
+{/*{{{*/
+	if (!zplo->lines) {
+		zplo->lines = new parle_line_index{0, 0, {}, zplo->in_offset};
+	}
+	php_parle_token_position(tok, *zplo->lines, zplo->in->data(), zplo->in_offset, offset);
+}/*}}}*/
+
 /* {{{ public void Lexer::push(...) */
 PHP_METHOD(ParleLexer, push)
 {
@@ -217,13 +757,18 @@ PHP_METHOD(ParleRLexer, push)
 }
 /* }}} */
 
+/* Lexers with at least this many start states have the DFAs of the
+	states built concurrently on the thread pool. */
+#define PARLE_PARALLEL_MIN_STATES 4
+
 template<typename lexer_obj_type> void
 _lexer_build(INTERNAL_FUNCTION_PARAMETERS, zend_class_entry *ce) noexcept
 {/*{{{*/
 	lexer_obj_type *zplo;
 	zval *me;
+	zend_long lazy_states = 0;
 
-	if(zend_parse_method_parameters(ZEND_NUM_ARGS(), getThis(), "O", &me, ce) == FAILURE) {
+	if(zend_parse_method_parameters(ZEND_NUM_ARGS(), getThis(), "O|l", &me, ce, &lazy_states) == FAILURE) {
 		return;
 	}
 
@@ -232,10 +777,29 @@ _lexer_build(INTERNAL_FUNCTION_PARAMETERS, zend_class_entry *ce) noexcept
 	if (zplo->complete) {
 		zend_throw_exception(ParleLexerException_ce, "Lexer state machine is readonly", 0);
 		return;
+	} else if (lazy_states < 0) {
+		zend_throw_exception_ex(ParleLexerException_ce, 0, "Invalid lazy state count " ZEND_LONG_FMT, lazy_states);
+		return;
 	}
 
 	try {
-		lexertl::generator::build(*zplo->rules, *zplo->sm);
+		/* A lexer state whose DFA would grow past parle.lexer_max_states
+			rows is built lazily instead, with a cache of that size. */
+		zend_long max_states = INI_INT("parle.lexer_max_states");
+		size_t max_rows = max_states > 0 ? static_cast<size_t>(max_states) : ~static_cast<size_t>(0);
+
+		/* The DFA rows are built as lexing first reaches them, and each
+			lexer state drops its rows between tokens once it holds more
+			than lazy_states of them. */
+		if (lazy_states > 0) {
+			lexertl::generator::build_lazy(*zplo->rules, *zplo->sm, static_cast<size_t>(lazy_states));
+		} else if (zplo->rules->statemap().size() >= PARLE_PARALLEL_MIN_STATES && php_parle_thread_pool().size() > 0) {
+			lexertl::generator::build(*zplo->rules, *zplo->sm, [](size_t n, const auto &f) {
+				php_parle_thread_pool().run(n, f);
+			}, max_rows);
+		} else {
+			lexertl::generator::build(*zplo->rules, *zplo->sm, lexertl::generator::serial_runner(), max_rows);
+		}
 	} catch (const std::exception &e) {
 		zend_throw_exception(ParleLexerException_ce, e.what(), 0);
 	}
@@ -243,14 +807,14 @@ _lexer_build(INTERNAL_FUNCTION_PARAMETERS, zend_class_entry *ce) noexcept
 	zplo->complete = true;
 }/*}}}*/
 
-/* {{{ public void Lexer::build(void) */
+/* {{{ public void Lexer::build([int $lazy_states]) */
 PHP_METHOD(ParleLexer, build)
 {
 	_lexer_build<struct ze_parle_lexer_obj>(INTERNAL_FUNCTION_PARAM_PASSTHRU, ParleLexer_ce);
 }
 /* }}} */
 
-/* {{{ public void RLexer::build(void) */
+/* {{{ public void RLexer::build([int $lazy_states]) */
 PHP_METHOD(ParleRLexer, build)
 {
 	_lexer_build<struct ze_parle_rlexer_obj>(INTERNAL_FUNCTION_PARAM_PASSTHRU, ParleRLexer_ce);
@@ -280,7 +844,19 @@ _lexer_consume(INTERNAL_FUNCTION_PARAMETERS, zend_class_entry *ce) noexcept
 		if (zplo->in) {
 			delete zplo->in;
 		}
-		zplo->in = new std::string{in};
+		zplo->in = new parle_string{in};
+		zplo->in_offset = 0;
+		delete zplo->in_state;
+		zplo->in_state = nullptr;
+		php_parle_lexer_drop_lookahead(zplo);
+		if (zplo->lines) {
+			delete zplo->lines;
+			zplo->lines = nullptr;
+		}
+		if (zplo->checkpoints) {
+			delete zplo->checkpoints;
+			zplo->checkpoints = nullptr;
+		}
 		if (zplo->results) {
 			delete zplo->results;
 		}
@@ -293,14 +869,14 @@ _lexer_consume(INTERNAL_FUNCTION_PARAMETERS, zend_class_entry *ce) noexcept
 /* {{{ public void Lexer::consume(string $s) */
 PHP_METHOD(ParleLexer, consume)
 {
-	_lexer_consume<struct ze_parle_lexer_obj, lexertl::smatch>(INTERNAL_FUNCTION_PARAM_PASSTHRU, ParleLexer_ce);
+	_lexer_consume<struct ze_parle_lexer_obj, parle_smatch>(INTERNAL_FUNCTION_PARAM_PASSTHRU, ParleLexer_ce);
 }
 /* }}} */
 
 /* {{{ public void RLexer::consume(string $s) */
 PHP_METHOD(ParleRLexer, consume)
 {
-	_lexer_consume<struct ze_parle_rlexer_obj, lexertl::srmatch>(INTERNAL_FUNCTION_PARAM_PASSTHRU, ParleRLexer_ce);
+	_lexer_consume<struct ze_parle_rlexer_obj, parle_srmatch>(INTERNAL_FUNCTION_PARAM_PASSTHRU, ParleRLexer_ce);
 }
 /* }}} */
 
@@ -347,6 +923,28 @@ PHP_METHOD(ParleRLexer, state)
 }
 /* }}} */
 
+/* Lex the next token not dropped by the filter. */
+template<typename lexer_obj_type, typename lexer_type> static void
+php_parle_lexer_next(const lexer_obj_type *zplo, lexer_type &results)
+{/*{{{*/
+	lexertl::lookup(*zplo->sm, results);
+	if (zplo->filter) {
+		while (results.id != zplo->sm->eoi() && zplo->filter->has(results.id)) {
+			lexertl::lookup(*zplo->sm, results);
+		}
+	}
+}/*}}}*/
+
+/* Forget the tokens lexed ahead, they're stale once the input, the
+	position or anything else affecting the lexing changes. */
+template<typename lexer_obj_type> static zend_always_inline void
+php_parle_lexer_drop_lookahead(lexer_obj_type *zplo) noexcept
+{/*{{{*/
+	if (zplo->lookahead) {
+		zplo->lookahead->clear();
+	}
+}/*}}}*/
+
 template<typename lexer_obj_type> void
 _lexer_token(INTERNAL_FUNCTION_PARAMETERS, zend_class_entry *ce) noexcept
 {/*{{{*/
@@ -365,16 +963,10 @@ _lexer_token(INTERNAL_FUNCTION_PARAMETERS, zend_class_entry *ce) noexcept
 	}
 
 	try {
-		object_init_ex(return_value, ParleToken_ce);
 		std::string ret = zplo->results->str();
-		add_property_long_ex(return_value, "id", sizeof("id")-1, static_cast<zend_long>(zplo->results->id));
-#if PHP_MAJOR_VERSION > 7 || PHP_MAJOR_VERSION >= 7 && PHP_MINOR_VERSION >= 2
-		add_property_stringl_ex(return_value, "value", sizeof("value")-1, ret.c_str(), ret.size());
-#else
-		add_property_stringl_ex(return_value, "value", sizeof("value")-1, (char *)ret.c_str(), ret.size());
-#endif
-		add_property_long(return_value, "offset", zplo->results->first - zplo->in->begin());
-
+		size_t offset = zplo->in_offset + (zplo->results->first - zplo->in->begin());
+		php_parle_token_init(return_value, static_cast<zend_long>(zplo->results->id), ret.c_str(), ret.size(), offset);
+		php_parle_lexer_token_position(zplo, return_value, offset);
 	} catch (const std::exception &e) {
 		zend_throw_exception(ParleLexerException_ce, e.what(), 0);
 	}
@@ -412,7 +1004,12 @@ _lexer_advance(INTERNAL_FUNCTION_PARAMETERS, zend_class_entry *ce) noexcept
 	}
 
 	try {
-		lexertl::lookup(*zplo->sm, *zplo->results);
+		if (zplo->lookahead && !zplo->lookahead->empty()) {
+			*zplo->results = zplo->lookahead->front();
+			zplo->lookahead->pop_front();
+		} else {
+			php_parle_lexer_next(zplo, *zplo->results);
+		}
 	} catch (const std::exception &e) {
 		zend_throw_exception(ParleLexerException_ce, e.what(), 0);
 	}
@@ -432,6 +1029,72 @@ PHP_METHOD(ParleRLexer, advance)
 }
 /* }}} */
 
+template<typename lexer_obj_type, typename lexer_type> void
+_lexer_peek(INTERNAL_FUNCTION_PARAMETERS, zend_class_entry *ce) noexcept
+{/*{{{*/
+	lexer_obj_type *zplo;
+	zval *me;
+	zend_long n = 1;
+
+	if(zend_parse_method_parameters(ZEND_NUM_ARGS(), getThis(), "O|l", &me, ce, &n) == FAILURE) {
+		return;
+	}
+
+	zplo = _php_parle_lexer_fetch_zobj<lexer_obj_type>(Z_OBJ_P(me));
+
+	if (!zplo->complete) {
+		zend_throw_exception(ParleLexerException_ce, "Lexer state machine is not ready", 0);
+		return;
+	} else if (!zplo->results) {
+		zend_throw_exception(ParleLexerException_ce, "No results available", 0);
+		return;
+	} else if (n < 1) {
+		zend_throw_exception_ex(ParleLexerException_ce, 0, "Invalid lookahead " ZEND_LONG_FMT, n);
+		return;
+	}
+
+	try {
+		if (!zplo->lookahead) {
+			zplo->lookahead = new parle_deque<lexer_type>{};
+		}
+
+		parle_deque<lexer_type> &la = *zplo->lookahead;
+
+		/* Lex only what wasn't peeked at yet, nothing past the end of input. */
+		while (la.size() < static_cast<size_t>(n)) {
+			lexer_type next = la.empty() ? *zplo->results : la.back();
+
+			if (next.id == zplo->sm->eoi() && next.first == next.eoi) {
+				break;
+			}
+			php_parle_lexer_next(zplo, next);
+			la.push_back(std::move(next));
+		}
+
+		const lexer_type &tok = static_cast<size_t>(n) <= la.size() ? la[n - 1] : la.empty() ? *zplo->results : la.back();
+		std::string ret = tok.str();
+		size_t offset = zplo->in_offset + (tok.first - zplo->in->begin());
+		php_parle_token_init(return_value, static_cast<zend_long>(tok.id), ret.c_str(), ret.size(), offset);
+		php_parle_lexer_token_position(zplo, return_value, offset);
+	} catch (const std::exception &e) {
+		zend_throw_exception(ParleLexerException_ce, e.what(), 0);
+	}
+}/*}}}*/
+
+/* {{{ public Parle\Token Lexer::peek([int $n = 1]) */
+PHP_METHOD(ParleLexer, peek)
+{
+	_lexer_peek<struct ze_parle_lexer_obj, parle_smatch>(INTERNAL_FUNCTION_PARAM_PASSTHRU, ParleLexer_ce);
+}
+/* }}} */
+
+/* {{{ public Parle\Token RLexer::peek([int $n = 1]) */
+PHP_METHOD(ParleRLexer, peek)
+{
+	_lexer_peek<struct ze_parle_rlexer_obj, parle_srmatch>(INTERNAL_FUNCTION_PARAM_PASSTHRU, ParleRLexer_ce);
+}
+/* }}} */
+
 template<typename lexer_obj_type> void
 _lexer_bol(INTERNAL_FUNCTION_PARAMETERS, zend_class_entry *ce) noexcept
 {/*{{{*/
@@ -454,6 +1117,7 @@ _lexer_bol(INTERNAL_FUNCTION_PARAMETERS, zend_class_entry *ce) noexcept
 		RETURN_BOOL(zplo->results->bol);
 	} else {
 		zplo->results->bol = bol;
+		php_parle_lexer_drop_lookahead(zplo);
 	}
 }/*}}}*/
 
@@ -493,6 +1157,7 @@ _lexer_restart(INTERNAL_FUNCTION_PARAMETERS, zend_class_entry *ce) noexcept
 	}
 
 	zplo->results->first = zplo->results->second = zplo->in->begin() + pos;
+	php_parle_lexer_drop_lookahead(zplo);
 }/*}}}*/
 
 /* {{{ public void Lexer::restart(int $position) */
@@ -509,55 +1174,226 @@ PHP_METHOD(ParleRLexer, restart)
 }
 /* }}} */
 
-template<typename lexer_obj_type> void
-_lexer_flags(INTERNAL_FUNCTION_PARAMETERS, zend_class_entry *ce) noexcept
+template<typename lexer_obj_type, typename cursor_obj_type, typename lexer_type> void
+_lexer_cursor(INTERNAL_FUNCTION_PARAMETERS, zend_class_entry *ce, zend_class_entry *cursor_ce) noexcept
 {/*{{{*/
 	lexer_obj_type *zplo;
+	cursor_obj_type *zpco;
 	zval *me;
-	zend_long flags = -1;
+	zend_string *in;
 
-	if(zend_parse_method_parameters(ZEND_NUM_ARGS(), getThis(), "O|l", &me, ce, &flags) == FAILURE) {
+	if(zend_parse_method_parameters(ZEND_NUM_ARGS(), getThis(), "OS", &me, ce, &in) == FAILURE) {
 		return;
 	}
 
 	zplo = _php_parle_lexer_fetch_zobj<lexer_obj_type>(Z_OBJ_P(me));
 
-	if (flags > 0) {
-		zplo->rules->flags(static_cast<size_t>(flags));
+	if (!zplo->complete) {
+		zend_throw_exception(ParleLexerException_ce, "Lexer state machine is not ready", 0);
+		return;
 	}
 
-	RETURN_LONG(zplo->rules->flags());
+	object_init_ex(return_value, cursor_ce);
+	zpco = _php_parle_lexer_fetch_zobj<cursor_obj_type>(Z_OBJ_P(return_value));
+
+	try {
+		zpco->in = new parle_string(ZSTR_VAL(in), ZSTR_LEN(in));
+		zpco->results = new lexer_type(zpco->in->begin(), zpco->in->end());
+		if (zplo->filter) {
+			zpco->filter = new parle_id_filter(*zplo->filter);
+		}
+		zpco->sm = php_parle_shared_addref(zplo->sm);
+		zpco->complete = true;
+	} catch (const std::exception &e) {
+		zend_throw_exception(ParleLexerException_ce, e.what(), 0);
+	}
 }/*}}}*/
 
-/* {{{ public int Lexer::flags([int flags]) */
-PHP_METHOD(ParleLexer, flags)
+/* {{{ public Parle\LexerCursor Lexer::cursor(string $in) */
+PHP_METHOD(ParleLexer, cursor)
 {
-	_lexer_flags<struct ze_parle_lexer_obj>(INTERNAL_FUNCTION_PARAM_PASSTHRU, ParleLexer_ce);
+	_lexer_cursor<struct ze_parle_lexer_obj, struct ze_parle_lexer_cursor_obj, parle_smatch>(INTERNAL_FUNCTION_PARAM_PASSTHRU, ParleLexer_ce, ParleLexerCursor_ce);
 }
 /* }}} */
 
-/* {{{ public int RLexer::flags([int flags]) */
-PHP_METHOD(ParleRLexer, flags)
+/* {{{ public Parle\RLexerCursor RLexer::cursor(string $in) */
+PHP_METHOD(ParleRLexer, cursor)
 {
-	_lexer_flags<struct ze_parle_rlexer_obj>(INTERNAL_FUNCTION_PARAM_PASSTHRU, ParleRLexer_ce);
+	_lexer_cursor<struct ze_parle_rlexer_obj, struct ze_parle_rlexer_cursor_obj, parle_srmatch>(INTERNAL_FUNCTION_PARAM_PASSTHRU, ParleRLexer_ce, ParleRLexerCursor_ce);
 }
 /* }}} */
 
-template<typename lexer_obj_type> void
-_lexer_macro(INTERNAL_FUNCTION_PARAMETERS, zend_class_entry *ce) noexcept
-{/*{{{*/
-	lexer_obj_type *zplo;
-	zval *me;
-	zend_string *name, *regex, *regex_begin, *regex_end;
+/* {{{ public void LexerCursor::advance(void) */
+PHP_METHOD(ParleLexerCursor, advance)
+{
+	_lexer_advance<struct ze_parle_lexer_cursor_obj>(INTERNAL_FUNCTION_PARAM_PASSTHRU, ParleLexerCursor_ce);
+}
+/* }}} */
 
-	try {
-		if(zend_parse_method_parameters_ex(ZEND_PARSE_PARAMS_QUIET, ZEND_NUM_ARGS(), getThis(), "OSS", &me, ce, &name, &regex) == SUCCESS) {
-			zplo = _php_parle_lexer_fetch_zobj<lexer_obj_type>(Z_OBJ_P(me));
-			zplo->rules->insert_macro(ZSTR_VAL(name), ZSTR_VAL(regex));
-		} else if(zend_parse_method_parameters_ex(ZEND_PARSE_PARAMS_QUIET, ZEND_NUM_ARGS(), getThis(), "OSSS", &me, ce, &name, &regex_begin, &regex_end) == SUCCESS) {
-			zplo = _php_parle_lexer_fetch_zobj<lexer_obj_type>(Z_OBJ_P(me));
-			zplo->rules->insert_macro(ZSTR_VAL(name), ZSTR_VAL(regex_begin), ZSTR_VAL(regex_end));
-		} else {
+/* {{{ public void RLexerCursor::advance(void) */
+PHP_METHOD(ParleRLexerCursor, advance)
+{
+	_lexer_advance<struct ze_parle_rlexer_cursor_obj>(INTERNAL_FUNCTION_PARAM_PASSTHRU, ParleRLexerCursor_ce);
+}
+/* }}} */
+
+/* {{{ public Parle\Token LexerCursor::getToken(void) */
+PHP_METHOD(ParleLexerCursor, getToken)
+{
+	_lexer_token<struct ze_parle_lexer_cursor_obj>(INTERNAL_FUNCTION_PARAM_PASSTHRU, ParleLexerCursor_ce);
+}
+/* }}} */
+
+/* {{{ public Parle\Token RLexerCursor::getToken(void) */
+PHP_METHOD(ParleRLexerCursor, getToken)
+{
+	_lexer_token<struct ze_parle_rlexer_cursor_obj>(INTERNAL_FUNCTION_PARAM_PASSTHRU, ParleRLexerCursor_ce);
+}
+/* }}} */
+
+/* {{{ public Parle\Token LexerCursor::peek([int $n = 1]) */
+PHP_METHOD(ParleLexerCursor, peek)
+{
+	_lexer_peek<struct ze_parle_lexer_cursor_obj, parle_smatch>(INTERNAL_FUNCTION_PARAM_PASSTHRU, ParleLexerCursor_ce);
+}
+/* }}} */
+
+/* {{{ public Parle\Token RLexerCursor::peek([int $n = 1]) */
+PHP_METHOD(ParleRLexerCursor, peek)
+{
+	_lexer_peek<struct ze_parle_rlexer_cursor_obj, parle_srmatch>(INTERNAL_FUNCTION_PARAM_PASSTHRU, ParleRLexerCursor_ce);
+}
+/* }}} */
+
+/* {{{ public mixed LexerCursor::bol([bool $bol]) */
+PHP_METHOD(ParleLexerCursor, bol)
+{
+	_lexer_bol<struct ze_parle_lexer_cursor_obj>(INTERNAL_FUNCTION_PARAM_PASSTHRU, ParleLexerCursor_ce);
+}
+/* }}} */
+
+/* {{{ public mixed RLexerCursor::bol([bool $bol]) */
+PHP_METHOD(ParleRLexerCursor, bol)
+{
+	_lexer_bol<struct ze_parle_rlexer_cursor_obj>(INTERNAL_FUNCTION_PARAM_PASSTHRU, ParleRLexerCursor_ce);
+}
+/* }}} */
+
+/* {{{ public void LexerCursor::restart(int $position) */
+PHP_METHOD(ParleLexerCursor, restart)
+{
+	_lexer_restart<struct ze_parle_lexer_cursor_obj>(INTERNAL_FUNCTION_PARAM_PASSTHRU, ParleLexerCursor_ce);
+}
+/* }}} */
+
+/* {{{ public void RLexerCursor::restart(int $position) */
+PHP_METHOD(ParleRLexerCursor, restart)
+{
+	_lexer_restart<struct ze_parle_rlexer_cursor_obj>(INTERNAL_FUNCTION_PARAM_PASSTHRU, ParleRLexerCursor_ce);
+}
+/* }}} */
+
+template<typename lexer_obj_type> void
+_lexer_flags(INTERNAL_FUNCTION_PARAMETERS, zend_class_entry *ce) noexcept
+{/*{{{*/
+	lexer_obj_type *zplo;
+	zval *me;
+	zend_long flags = -1;
+
+	if(zend_parse_method_parameters(ZEND_NUM_ARGS(), getThis(), "O|l", &me, ce, &flags) == FAILURE) {
+		return;
+	}
+
+	zplo = _php_parle_lexer_fetch_zobj<lexer_obj_type>(Z_OBJ_P(me));
+
+	try {
+		if (flags > 0) {
+			/* The rules may be shared with clones, but the flags are not. */
+			php_parle_shared_separate(zplo->rules);
+			zplo->rules->flags(static_cast<size_t>(flags));
+		}
+	} catch (const std::exception &e) {
+		zend_throw_exception(ParleLexerException_ce, e.what(), 0);
+		return;
+	}
+
+	RETURN_LONG(zplo->rules->flags());
+}/*}}}*/
+
+/* {{{ public int Lexer::flags([int flags]) */
+PHP_METHOD(ParleLexer, flags)
+{
+	_lexer_flags<struct ze_parle_lexer_obj>(INTERNAL_FUNCTION_PARAM_PASSTHRU, ParleLexer_ce);
+}
+/* }}} */
+
+/* {{{ public int RLexer::flags([int flags]) */
+PHP_METHOD(ParleRLexer, flags)
+{
+	_lexer_flags<struct ze_parle_rlexer_obj>(INTERNAL_FUNCTION_PARAM_PASSTHRU, ParleRLexer_ce);
+}
+/* }}} */
+
+template<typename lexer_obj_type> void
+_lexer_filter(INTERNAL_FUNCTION_PARAMETERS, zend_class_entry *ce) noexcept
+{/*{{{*/
+	lexer_obj_type *zplo;
+	zval *me, *ids, *id;
+
+	if(zend_parse_method_parameters(ZEND_NUM_ARGS(), getThis(), "Oa", &me, ce, &ids) == FAILURE) {
+		return;
+	}
+
+	zplo = _php_parle_lexer_fetch_zobj<lexer_obj_type>(Z_OBJ_P(me));
+
+	try {
+		php_parle_lexer_drop_lookahead(zplo);
+		if (zplo->filter) {
+			delete zplo->filter;
+			zplo->filter = nullptr;
+		}
+		if (zend_hash_num_elements(Z_ARRVAL_P(ids)) > 0) {
+			zplo->filter = new parle_id_filter{};
+			ZEND_HASH_FOREACH_VAL(Z_ARRVAL_P(ids), id) {
+				zplo->filter->insert(static_cast<size_t>(zval_get_long(id)));
+			} ZEND_HASH_FOREACH_END();
+		}
+	} catch (const std::exception &e) {
+		zend_throw_exception(ParleLexerException_ce, e.what(), 0);
+	}
+}/*}}}*/
+
+/* {{{ public void Lexer::setFilter(array $ids) */
+PHP_METHOD(ParleLexer, setFilter)
+{
+	_lexer_filter<struct ze_parle_lexer_obj>(INTERNAL_FUNCTION_PARAM_PASSTHRU, ParleLexer_ce);
+}
+/* }}} */
+
+/* {{{ public void RLexer::setFilter(array $ids) */
+PHP_METHOD(ParleRLexer, setFilter)
+{
+	_lexer_filter<struct ze_parle_rlexer_obj>(INTERNAL_FUNCTION_PARAM_PASSTHRU, ParleRLexer_ce);
+}
+/* }}} */
+
+template<typename lexer_obj_type> void
+_lexer_macro(INTERNAL_FUNCTION_PARAMETERS, zend_class_entry *ce) noexcept
+{/*{{{*/
+	lexer_obj_type *zplo;
+	zval *me;
+	zend_string *name, *regex, *regex_begin, *regex_end;
+
+	try {
+		if(zend_parse_method_parameters_ex(ZEND_PARSE_PARAMS_QUIET, ZEND_NUM_ARGS(), getThis(), "OSS", &me, ce, &name, &regex) == SUCCESS) {
+			zplo = _php_parle_lexer_fetch_zobj<lexer_obj_type>(Z_OBJ_P(me));
+			php_parle_shared_separate(zplo->rules);
+			zplo->rules->insert_macro(ZSTR_VAL(name), ZSTR_VAL(regex));
+		} else if(zend_parse_method_parameters_ex(ZEND_PARSE_PARAMS_QUIET, ZEND_NUM_ARGS(), getThis(), "OSSS", &me, ce, &name, &regex_begin, &regex_end) == SUCCESS) {
+			zplo = _php_parle_lexer_fetch_zobj<lexer_obj_type>(Z_OBJ_P(me));
+			php_parle_shared_separate(zplo->rules);
+			zplo->rules->insert_macro(ZSTR_VAL(name), ZSTR_VAL(regex_begin), ZSTR_VAL(regex_end));
+		} else {
 			zend_throw_exception(ParleLexerException_ce, "Couldn't match the method signature", 0);
 		}
 	} catch (const std::exception &e) {
@@ -565,60 +1401,1219 @@ _lexer_macro(INTERNAL_FUNCTION_PARAMETERS, zend_class_entry *ce) noexcept
 	}
 }/*}}}*/
 
-/* {{{ public void Lexer::insertMacro(string $name, string $reg) */
-PHP_METHOD(ParleLexer, insertMacro)
+/* {{{ public void Lexer::insertMacro(string $name, string $reg) */
+PHP_METHOD(ParleLexer, insertMacro)
+{
+	_lexer_macro<struct ze_parle_lexer_obj>(INTERNAL_FUNCTION_PARAM_PASSTHRU, ParleLexer_ce);
+}
+/* }}} */
+
+/* {{{ public void RLexer::insertMacro(string $name, string $reg) */
+PHP_METHOD(ParleRLexer, insertMacro)
+{
+	_lexer_macro<struct ze_parle_rlexer_obj>(INTERNAL_FUNCTION_PARAM_PASSTHRU, ParleRLexer_ce);
+}
+/* }}} */
+
+template<typename lexer_obj_type> void
+_lexer_keywords(INTERNAL_FUNCTION_PARAMETERS, zend_class_entry *ce) noexcept
+{/*{{{*/
+	lexer_obj_type *zplo;
+	zval *me, *map, *id;
+	zend_long identifier_id;
+	zend_bool icase = 0;
+	zend_string *word;
+
+	if(zend_parse_method_parameters(ZEND_NUM_ARGS(), getThis(), "Oal|b", &me, ce, &map, &identifier_id, &icase) == FAILURE) {
+		return;
+	}
+
+	zplo = _php_parle_lexer_fetch_zobj<lexer_obj_type>(Z_OBJ_P(me));
+
+	if (zplo->complete) {
+		zend_throw_exception(ParleLexerException_ce, "Lexer state machine is readonly", 0);
+		return;
+	}
+
+	try {
+		lexertl::rules::keyword_vector keywords;
+
+		keywords.reserve(zend_hash_num_elements(Z_ARRVAL_P(map)));
+		ZEND_HASH_FOREACH_STR_KEY_VAL(Z_ARRVAL_P(map), word, id) {
+			if (!word) {
+				zend_throw_exception(ParleLexerException_ce, "Keywords must be string keys", 0);
+				return;
+			}
+			keywords.emplace_back(std::string{ZSTR_VAL(word), ZSTR_LEN(word)}, static_cast<size_t>(zval_get_long(id)));
+		} ZEND_HASH_FOREACH_END();
+
+		/* Matches of the identifier rule are looked up in a perfect hash
+			table when lexing, the keywords never make it into the DFA. */
+		php_parle_shared_separate(zplo->rules);
+		zplo->rules->keywords(static_cast<size_t>(identifier_id), keywords, icase);
+	} catch (const std::exception &e) {
+		zend_throw_exception(ParleLexerException_ce, e.what(), 0);
+	}
+}/*}}}*/
+
+/* {{{ public void Lexer::keywords(array $map, int $identifierId [, bool $icase = false]) */
+PHP_METHOD(ParleLexer, keywords)
+{
+	_lexer_keywords<struct ze_parle_lexer_obj>(INTERNAL_FUNCTION_PARAM_PASSTHRU, ParleLexer_ce);
+}
+/* }}} */
+
+/* {{{ public void RLexer::keywords(array $map, int $identifierId [, bool $icase = false]) */
+PHP_METHOD(ParleRLexer, keywords)
+{
+	_lexer_keywords<struct ze_parle_rlexer_obj>(INTERNAL_FUNCTION_PARAM_PASSTHRU, ParleRLexer_ce);
+}
+/* }}} */
+
+template<typename lexer_obj_type> void
+_lexer_dump(INTERNAL_FUNCTION_PARAMETERS, zend_class_entry *ce) noexcept
+{/*{{{*/
+	lexer_obj_type *zplo;
+	zval *me;
+
+	if(zend_parse_method_parameters(ZEND_NUM_ARGS(), getThis(), "O", &me, ce) == FAILURE) {
+		return;
+	}
+
+	zplo = _php_parle_lexer_fetch_zobj<lexer_obj_type>(Z_OBJ_P(me));
+
+	if (!zplo->complete) {
+		zend_throw_exception(ParleLexerException_ce, "Lexer state machine is not ready", 0);
+		return;
+	}
+
+	try {
+		/* XXX std::cout might be not thread safe, need to gather the right
+			descriptor from the SAPI and convert to a usable stream. */
+		zplo->sm->complete();
+		lexertl::debug::dump(*zplo->sm, *zplo->rules, std::cout);
+	} catch (const std::exception &e) {
+		zend_throw_exception(ParleLexerException_ce, e.what(), 0);
+	}
+}
+/* }}} */
+
+/* {{{ public void Lexer::dump(void) */
+PHP_METHOD(ParleLexer, dump)
+{
+	_lexer_dump<struct ze_parle_lexer_obj>(INTERNAL_FUNCTION_PARAM_PASSTHRU, ParleLexer_ce);
+}
+/* }}} */
+
+/* {{{ public void RLexer::dump(void) */
+PHP_METHOD(ParleRLexer, dump)
+{
+	_lexer_dump<struct ze_parle_rlexer_obj>(INTERNAL_FUNCTION_PARAM_PASSTHRU, ParleRLexer_ce);
+}
+/* }}} */
+
+/* Heap bytes held by a container, not counting the container itself. */
+template<typename T, typename A> static zend_always_inline size_t
+php_parle_bytes(const std::vector<T, A> &v) noexcept
+{/*{{{*/
+	return v.capacity() * sizeof(T);
+}/*}}}*/
+
+template<typename C, typename A> static zend_always_inline size_t
+php_parle_bytes(const std::basic_string<C, std::char_traits<C>, A> &s) noexcept
+{/*{{{*/
+	return (s.capacity() + 1) * sizeof(C);
+}/*}}}*/
+
+template<typename lexer_obj_type> void
+_lexer_stats(INTERNAL_FUNCTION_PARAMETERS, zend_class_entry *ce) noexcept
+{/*{{{*/
+	lexer_obj_type *zplo;
+	zval *me, states, bytes;
+
+	if(zend_parse_method_parameters(ZEND_NUM_ARGS(), getThis(), "O", &me, ce) == FAILURE) {
+		return;
+	}
+
+	zplo = _php_parle_lexer_fetch_zobj<lexer_obj_type>(Z_OBJ_P(me));
+
+	if (!zplo->complete) {
+		zend_throw_exception(ParleLexerException_ce, "Lexer state machine is not ready", 0);
+		return;
+	}
+
+	const auto &internals = zplo->sm->data();
+	std::vector<const std::string *> names(internals._dfa.size(), nullptr);
+	size_t rows = 0, lookup_bytes = 0, dfa_bytes = 0, results_bytes = 0;
+
+	for (const auto &st : zplo->rules->statemap()) {
+		if (st.second < names.size()) {
+			names[st.second] = &st.first;
+		}
+	}
+
+	array_init(return_value);
+	array_init(&states);
+
+	/* Rows of a lazily built lexer state are the ones built so far. The
+		alphabet is the number of character classes, the DFA has a column
+		for each of them after the lexertl::transitions_index header. */
+	for (size_t i = 0; i < names.size(); i++) {
+		zval st;
+		size_t state_rows = internals._dfa[i].size() / internals._dfa_alphabet[i];
+
+		array_init(&st);
+		add_assoc_long_ex(&st, "rows", sizeof("rows")-1, static_cast<zend_long>(state_rows));
+		add_assoc_bool_ex(&st, "lazy", sizeof("lazy")-1, internals._lazy && internals._lazy->lazy(i));
+		add_assoc_long_ex(&st, "alphabet", sizeof("alphabet")-1, static_cast<zend_long>(internals._dfa_alphabet[i] - lexertl::transitions_index));
+		add_assoc_zval_ex(&states, names[i]->c_str(), names[i]->size(), &st);
+
+		rows += state_rows;
+		lookup_bytes += php_parle_bytes(internals._lookup[i]);
+		dfa_bytes += php_parle_bytes(internals._dfa[i]);
+	}
+
+	add_assoc_zval_ex(return_value, "states", sizeof("states")-1, &states);
+	add_assoc_long_ex(return_value, "dfas", sizeof("dfas")-1, static_cast<zend_long>(internals._dfa.size()));
+	add_assoc_long_ex(return_value, "rows", sizeof("rows")-1, static_cast<zend_long>(rows));
+
+	/* The state machine is shared with clones and cursors, the input and
+		results are this lexer's own. */
+	if (zplo->results) {
+		results_bytes += sizeof(*zplo->results);
+	}
+	if (zplo->lookahead) {
+		results_bytes += zplo->lookahead->size() * sizeof(*zplo->results);
+	}
+	if (zplo->checkpoints) {
+		results_bytes += php_parle_bytes(*zplo->checkpoints);
+	}
+	if (zplo->lines) {
+		results_bytes += php_parle_bytes(zplo->lines->starts);
+	}
+
+	array_init(&bytes);
+	add_assoc_long_ex(&bytes, "lookup", sizeof("lookup")-1, static_cast<zend_long>(lookup_bytes + php_parle_bytes(internals._lookup)));
+	add_assoc_long_ex(&bytes, "dfa", sizeof("dfa")-1, static_cast<zend_long>(dfa_bytes + php_parle_bytes(internals._dfa) + php_parle_bytes(internals._dfa_alphabet)));
+	add_assoc_long_ex(&bytes, "input", sizeof("input")-1, static_cast<zend_long>(zplo->in ? php_parle_bytes(*zplo->in) : 0));
+	add_assoc_long_ex(&bytes, "results", sizeof("results")-1, static_cast<zend_long>(results_bytes));
+	add_assoc_zval_ex(return_value, "bytes", sizeof("bytes")-1, &bytes);
+}/*}}}*/
+
+/* {{{ public array Lexer::stats(void) */
+PHP_METHOD(ParleLexer, stats)
+{
+	_lexer_stats<struct ze_parle_lexer_obj>(INTERNAL_FUNCTION_PARAM_PASSTHRU, ParleLexer_ce);
+}
+/* }}} */
+
+/* {{{ public array RLexer::stats(void) */
+PHP_METHOD(ParleRLexer, stats)
+{
+	_lexer_stats<struct ze_parle_rlexer_obj>(INTERNAL_FUNCTION_PARAM_PASSTHRU, ParleRLexer_ce);
+}
+/* }}} */
+
+template<typename lexer_obj_type, typename lexer_type> void
+_lexer_replace(INTERNAL_FUNCTION_PARAMETERS, zend_class_entry *ce) noexcept
+{/*{{{*/
+	lexer_obj_type *zplo;
+	zval *me, *repl;
+	zend_string *in;
+
+	if(zend_parse_method_parameters(ZEND_NUM_ARGS(), getThis(), "OSz", &me, ce, &in, &repl) == FAILURE) {
+		return;
+	}
+
+	zplo = _php_parle_lexer_fetch_zobj<lexer_obj_type>(Z_OBJ_P(me));
+
+	if (!zplo->complete) {
+		zend_throw_exception(ParleLexerException_ce, "Lexer state machine is not ready", 0);
+		return;
+	}
+
+	bool use_map = Z_TYPE_P(repl) == IS_ARRAY;
+	if (!use_map && !zend_is_callable(repl, 0, NULL)) {
+		zend_throw_exception(ParleLexerException_ce, "Replacements must be an array or a callable", 0);
+		return;
+	}
+
+	smart_str buf = {0};
+	bool replaced = false;
+
+	try {
+		const char *start = ZSTR_VAL(in), *end = ZSTR_VAL(in) + ZSTR_LEN(in);
+		/* Start of the input part not yet copied to the output. Bytes are
+			only copied when a replacement is due, so unmatched stretches
+			and skipped tokens go out with a single append. */
+		const char *pending = start;
+		lexer_type results(start, end);
+		struct parle_line_index lines{0, 0, {}, 0};
+
+		lexertl::lookup(*zplo->sm, results);
+
+		while (results.id != zplo->sm->eoi()) {
+			zval *subst = nullptr;
+
+			if (use_map) {
+				subst = zend_hash_index_find(Z_ARRVAL_P(repl), static_cast<zend_ulong>(results.id));
+			} else {
+				subst = repl;
+			}
+
+			if (subst) {
+				replaced = true;
+				smart_str_appendl(&buf, pending, results.first - pending);
+				pending = results.second;
+
+				if (Z_TYPE_P(subst) == IS_STRING) {
+					/* A string from the map is always literal, even if it names a function. */
+					smart_str_append(&buf, Z_STR_P(subst));
+				} else {
+					zval tok, retval;
+
+					php_parle_token_init(&tok, static_cast<zend_long>(results.id), results.first, results.second - results.first, results.first - start);
+					php_parle_token_position(&tok, lines, start, 0, results.first - start);
+					ZVAL_UNDEF(&retval);
+					int ret = call_user_function(EG(function_table), NULL, subst, &retval, 1, &tok);
+					zval_ptr_dtor(&tok);
+
+					if (ret == FAILURE || EG(exception)) {
+						zval_ptr_dtor(&retval);
+						if (!EG(exception)) {
+							zend_throw_exception_ex(ParleLexerException_ce, 0, "Failed to invoke replacement for token id " ZEND_LONG_FMT, static_cast<zend_long>(results.id));
+						}
+						smart_str_free(&buf);
+						return;
+					}
+
+					zend_string *str = zval_get_string(&retval);
+					smart_str_append(&buf, str);
+					zend_string_release(str);
+					zval_ptr_dtor(&retval);
+				}
+			}
+
+			lexertl::lookup(*zplo->sm, results);
+		}
+
+		if (!replaced) {
+			/* Nothing was replaced, hand back the input itself. */
+			RETURN_STR(zend_string_copy(in));
+		}
+
+		smart_str_appendl(&buf, pending, end - pending);
+		smart_str_0(&buf);
+		RETURN_STR(buf.s);
+	} catch (const std::exception &e) {
+		smart_str_free(&buf);
+		zend_throw_exception(ParleLexerException_ce, e.what(), 0);
+	}
+}/*}}}*/
+
+/* {{{ public string Lexer::replace(string $in, mixed $replacements) */
+PHP_METHOD(ParleLexer, replace)
+{
+	_lexer_replace<struct ze_parle_lexer_obj, lexertl::cmatch>(INTERNAL_FUNCTION_PARAM_PASSTHRU, ParleLexer_ce);
+}
+/* }}} */
+
+/* {{{ public string RLexer::replace(string $in, mixed $replacements) */
+PHP_METHOD(ParleRLexer, replace)
+{
+	_lexer_replace<struct ze_parle_rlexer_obj, lexertl::crmatch>(INTERNAL_FUNCTION_PARAM_PASSTHRU, ParleRLexer_ce);
+}
+/* }}} */
+
+template<typename lexer_obj_type, typename lexer_type> void
+_lexer_split(INTERNAL_FUNCTION_PARAMETERS, zend_class_entry *ce) noexcept
+{/*{{{*/
+	lexer_obj_type *zplo;
+	zval *me;
+	zend_string *in;
+
+	if(zend_parse_method_parameters(ZEND_NUM_ARGS(), getThis(), "OS", &me, ce, &in) == FAILURE) {
+		return;
+	}
+
+	zplo = _php_parle_lexer_fetch_zobj<lexer_obj_type>(Z_OBJ_P(me));
+
+	if (!zplo->complete) {
+		zend_throw_exception(ParleLexerException_ce, "Lexer state machine is not ready", 0);
+		return;
+	}
+
+	array_init(return_value);
+
+	try {
+		lexer_type results(ZSTR_VAL(in), ZSTR_VAL(in) + ZSTR_LEN(in));
+
+		lexertl::lookup(*zplo->sm, results);
+
+		while (results.id != zplo->sm->eoi()) {
+			add_next_index_stringl(return_value, results.first, results.second - results.first);
+			lexertl::lookup(*zplo->sm, results);
+		}
+	} catch (const std::exception &e) {
+		zend_throw_exception(ParleLexerException_ce, e.what(), 0);
+	}
+}/*}}}*/
+
+/* {{{ public array Lexer::split(string $in) */
+PHP_METHOD(ParleLexer, split)
+{
+	_lexer_split<struct ze_parle_lexer_obj, lexertl::cmatch>(INTERNAL_FUNCTION_PARAM_PASSTHRU, ParleLexer_ce);
+}
+/* }}} */
+
+/* {{{ public array RLexer::split(string $in) */
+PHP_METHOD(ParleRLexer, split)
+{
+	_lexer_split<struct ze_parle_rlexer_obj, lexertl::crmatch>(INTERNAL_FUNCTION_PARAM_PASSTHRU, ParleRLexer_ce);
+}
+/* }}} */
+
+/* Chunks handed to a thread by the parallel lexing are at least this big. */
+#define PARLE_PARALLEL_MIN_CHUNK (64 * 1024)
+
+/* A token lexed on a thread, along with the lexer state after it. */
+struct parle_span_token {/*{{{*/
+	size_t id;
+	size_t first;
+	size_t second;
+	size_t state;
+	bool bol;
+};/*}}}*/
+
+/* Lex in from start in the initial state until the first token boundary
+	at or past stop. Runs off the PHP thread, so no Zend API in here. */
+static void
+php_parle_lexer_lex_span(const lexertl::state_machine &sm, const char *in, size_t in_len, size_t start, size_t stop,
+	std::vector<struct parle_span_token> &toks) noexcept
+{/*{{{*/
+	try {
+		lexertl::cmatch results(in + start, in + in_len);
+
+		results.bol = 0 == start || '\n' == in[start - 1];
+		lexertl::lookup(sm, results);
+
+		while (results.id != sm.eoi()) {
+			toks.push_back(parle_span_token{results.id, static_cast<size_t>(results.first - in),
+				static_cast<size_t>(results.second - in), results.state, results.bol});
+			if (toks.back().second >= stop) {
+				break;
+			}
+			lexertl::lookup(sm, results);
+		}
+	} catch (...) {
+		/* Leave the rest to the PHP thread, it lexes up to the next chunk. */
+		toks.clear();
+	}
+}/*}}}*/
+
+/* Lex in on up to threads chunks and pass the tokens to on_token() in
+	order. Chunks start right after a newline, which is where most grammars
+	are between tokens and in the initial state. They're lexed speculatively
+	on the pool, the tokens of a chunk are taken from the first boundary
+	where the exact lexing so far ends in the same state, until then the
+	PHP thread lexes on by itself. So the result is the same as of the
+	sequential lexing, even when a chunk starts inside a token. */
+template<typename F> static void
+php_parle_lexer_lex_parallel(const lexertl::state_machine &sm, const char *str, size_t len, size_t threads, const F &on_token)
+{/*{{{*/
+	size_t n = std::min(threads, std::max(len / PARLE_PARALLEL_MIN_CHUNK, static_cast<size_t>(1)));
+	std::vector<size_t> starts{0};
+
+	/* A lazily built DFA grows while lexing, so it can't be shared. */
+	if (sm.data()._lazy) {
+		n = 1;
+	}
+
+	for (size_t i = 1; i < n; i++) {
+		size_t pos = std::max(len / n * i, starts.back() + 1);
+		const char *nl = pos < len ? static_cast<const char *>(memchr(str + pos, '\n', len - pos)) : nullptr;
+
+		if (!nl || static_cast<size_t>(nl - str) + 1 >= len) {
+			break;
+		}
+		starts.push_back(nl - str + 1);
+	}
+	n = starts.size();
+	starts.push_back(len);
+
+	std::vector<std::vector<struct parle_span_token>> spans(n);
+
+	if (n > 1) {
+		php_parle_thread_pool().run(n, [&](size_t i) {
+			php_parle_lexer_lex_span(sm, str, len, starts[i], starts[i + 1], spans[i]);
+		});
+	} else {
+		php_parle_lexer_lex_span(sm, str, len, 0, len, spans[0]);
+	}
+
+	lexertl::cmatch exact(str, str + len);
+	size_t end = 0;
+
+	auto take = [&](const struct parle_span_token &tok) {
+		on_token(tok);
+		end = tok.second;
+		exact.state = tok.state;
+		exact.bol = tok.bol;
+	};
+	/* Returns false at the end of input. */
+	auto lex_exact = [&]() {
+		exact.first = exact.second = str + end;
+		lexertl::lookup(sm, exact);
+		if (exact.id == sm.eoi()) {
+			end = len;
+			return false;
+		}
+		take(parle_span_token{exact.id, static_cast<size_t>(exact.first - str), static_cast<size_t>(exact.second - str), exact.state, exact.bol});
+		return true;
+	};
+
+	for (size_t i = 0; i < n && end < len; i++) {
+		const auto &toks = spans[i];
+		size_t j = 0;
+
+		/* The chunk start is a boundary in the initial state. */
+		bool synced = end == starts[i] && 0 == exact.state && exact.bol == (0 == end || '\n' == str[end - 1]);
+
+		while (!synced) {
+			while (j < toks.size() && toks[j].second < end) {
+				j++;
+			}
+			if (j == toks.size()) {
+				break;
+			} else if (toks[j].second == end && toks[j].state == exact.state && toks[j].bol == exact.bol) {
+				synced = true;
+				j++;
+			} else if (!lex_exact()) {
+				break;
+			}
+		}
+
+		if (synced) {
+			for (; j < toks.size(); j++) {
+				take(toks[j]);
+			}
+		}
+	}
+
+	while (end < len && lex_exact());
+}/*}}}*/
+
+/* Token ids below this are counted in a flat table, any other id (most
+	notably Token::UNKNOWN) goes to an ordered map. */
+#define PARLE_COUNT_FLAT_MAX 4096
+
+struct parle_token_count {/*{{{*/
+	zend_ulong count;
+	zend_ulong bytes;
+};/*}}}*/
+
+static void
+php_parle_token_count_add(zval *ret, size_t id, const struct parle_token_count &cnt) noexcept
+{/*{{{*/
+	zval item;
+
+	array_init_size(&item, 2);
+	add_assoc_long_ex(&item, "count", sizeof("count")-1, static_cast<zend_long>(cnt.count));
+	add_assoc_long_ex(&item, "bytes", sizeof("bytes")-1, static_cast<zend_long>(cnt.bytes));
+	add_index_zval(ret, static_cast<zend_ulong>(static_cast<zend_long>(id)), &item);
+}/*}}}*/
+
+template<typename lexer_obj_type, typename lexer_type> void
+_lexer_count_tokens(INTERNAL_FUNCTION_PARAMETERS, zend_class_entry *ce) noexcept
+{/*{{{*/
+	lexer_obj_type *zplo;
+	zval *me;
+	zend_string *in;
+	zend_long threads = 1;
+
+	if(zend_parse_method_parameters(ZEND_NUM_ARGS(), getThis(), "OS|l", &me, ce, &in, &threads) == FAILURE) {
+		return;
+	}
+
+	zplo = _php_parle_lexer_fetch_zobj<lexer_obj_type>(Z_OBJ_P(me));
+
+	if (!zplo->complete) {
+		zend_throw_exception(ParleLexerException_ce, "Lexer state machine is not ready", 0);
+		return;
+	} else if (threads < 1) {
+		zend_throw_exception_ex(ParleLexerException_ce, 0, "Invalid thread count " ZEND_LONG_FMT, threads);
+		return;
+	}
+
+	try {
+		std::vector<struct parle_token_count> flat;
+		std::map<size_t, struct parle_token_count> sparse;
+		auto count = [&](size_t id, size_t bytes) {
+			struct parle_token_count *cnt;
+
+			if (id < flat.size()) {
+				cnt = &flat[id];
+			} else if (id < PARLE_COUNT_FLAT_MAX) {
+				flat.resize(id + 1, {0, 0});
+				cnt = &flat[id];
+			} else {
+				cnt = &sparse.emplace(id, parle_token_count{0, 0}).first->second;
+			}
+
+			cnt->count++;
+			cnt->bytes += bytes;
+		};
+
+		/* The recursive lexer can't resume from the middle of the input
+			without its stack, so it always counts on this thread. */
+		if (threads > 1 && std::is_same<lexer_type, lexertl::cmatch>::value) {
+			php_parle_lexer_lex_parallel(*zplo->sm, ZSTR_VAL(in), ZSTR_LEN(in), static_cast<size_t>(threads), [&](const struct parle_span_token &tok) {
+				count(tok.id, tok.second - tok.first);
+			});
+		} else {
+			lexer_type results(ZSTR_VAL(in), ZSTR_VAL(in) + ZSTR_LEN(in));
+
+			lexertl::lookup(*zplo->sm, results);
+
+			while (results.id != zplo->sm->eoi()) {
+				count(results.id, results.second - results.first);
+				lexertl::lookup(*zplo->sm, results);
+			}
+		}
+
+		array_init(return_value);
+		for (size_t id = 0; id < flat.size(); id++) {
+			if (flat[id].count) {
+				php_parle_token_count_add(return_value, id, flat[id]);
+			}
+		}
+		for (auto &it : sparse) {
+			php_parle_token_count_add(return_value, it.first, it.second);
+		}
+	} catch (const std::exception &e) {
+		zend_throw_exception(ParleLexerException_ce, e.what(), 0);
+	}
+}/*}}}*/
+
+/* {{{ public array Lexer::countTokens(string $in [, int $threads = 1]) */
+PHP_METHOD(ParleLexer, countTokens)
+{
+	_lexer_count_tokens<struct ze_parle_lexer_obj, lexertl::cmatch>(INTERNAL_FUNCTION_PARAM_PASSTHRU, ParleLexer_ce);
+}
+/* }}} */
+
+/* {{{ public array RLexer::countTokens(string $in [, int $threads = 1]) */
+PHP_METHOD(ParleRLexer, countTokens)
+{
+	_lexer_count_tokens<struct ze_parle_rlexer_obj, lexertl::crmatch>(INTERNAL_FUNCTION_PARAM_PASSTHRU, ParleRLexer_ce);
+}
+/* }}} */
+
+/* The longest match found by php_parle_lexer_dfa_reach(). */
+template<typename iter_type> struct parle_lexer_dfa_match {/*{{{*/
+	iter_type end;
+	size_t id;
+	/* The start state after the match, unless it pops the recursive stack,
+		and the state pushed onto the stack if any. */
+	size_t next;
+	size_t push;
+	bool pop;
+};/*}}}*/
+
+/* Returns where the DFA started in the given state at first dies, that is
+	the last character it has to look at, or last if the DFA is still alive
+	after reading everything up to last. In the latter case a match starting
+	at first could grow with more input. This mirrors lexertl::lookup() for
+	the uncompressed char case, including building lazy DFA rows, which can
+	throw like lookup() does. If match is passed, it receives the longest
+	match. */
+template<typename iter_type> static iter_type
+php_parle_lexer_dfa_reach(const lexertl::state_machine &sm, size_t state, bool bol, iter_type first, const iter_type &last,
+	struct parle_lexer_dfa_match<iter_type> *match = nullptr)
+{/*{{{*/
+	const auto &internals = sm.data();
+	const size_t *lookup = &internals._lookup[state].front();
+	const size_t alphabet = internals._dfa_alphabet[state];
+	const size_t *dfa = &internals._dfa[state].front();
+	const size_t *ptr = dfa + alphabet;
+	const size_t lazy_state = lexertl::detail::basic_lazy_dfa<size_t>::lazy_state();
+
+	if (bol && *dfa) {
+		ptr = &dfa[*dfa * alphabet];
+	}
+
+	while (first != last) {
+		const size_t eol_state = ptr[lexertl::eol_index];
+
+		if (eol_state && ('\r' == *first || '\n' == *first)) {
+			ptr = &dfa[eol_state * alphabet];
+			if (match && *ptr) {
+				*match = parle_lexer_dfa_match<iter_type>{first, ptr[lexertl::id_index], ptr[lexertl::next_dfa_index],
+					ptr[lexertl::push_dfa_index], (*ptr & lexertl::pop_dfa_bit) != 0};
+			}
+			continue;
+		}
+
+		const size_t col = lookup[static_cast<unsigned char>(*first)];
+
+		if (lazy_state == ptr[col]) {
+			const size_t row = (ptr - dfa) / alphabet;
+
+			internals._lazy->expand(internals, state, row);
+			dfa = &internals._dfa[state].front();
+			ptr = dfa + row * alphabet;
+		}
+
+		const size_t next = ptr[col];
+
+		if (!next) {
+			return first;
+		}
+
+		ptr = &dfa[next * alphabet];
+		++first;
+		if (match && *ptr) {
+			*match = parle_lexer_dfa_match<iter_type>{first, ptr[lexertl::id_index], ptr[lexertl::next_dfa_index],
+				ptr[lexertl::push_dfa_index], (*ptr & lexertl::pop_dfa_bit) != 0};
+		}
+	}
+
+	return last;
+}/*}}}*/
+
+/* Move the lexer state past a skipped token the way lookup() does. A
+	recursive lexer also pushes onto or pops from its stack. Returns false
+	if there's nothing to pop. */
+static zend_always_inline bool
+php_parle_lexer_skip_state(parle_smatch &lex, const struct parle_lexer_dfa_match<parle_smatch::iter_type> &match) noexcept
+{/*{{{*/
+	lex.state = match.next;
+	return true;
+}/*}}}*/
+
+static zend_always_inline bool
+php_parle_lexer_skip_state(parle_srmatch &lex, const struct parle_lexer_dfa_match<parle_srmatch::iter_type> &match)
+{/*{{{*/
+	if (match.pop) {
+		if (lex.stack.empty()) {
+			return false;
+		}
+		lex.state = lex.stack.top().first;
+		lex.stack.pop();
+		return true;
+	}
+	if (match.push != parle_srmatch::npos()) {
+		lex.stack.push(parle_srmatch::id_type_pair(match.push, match.id));
+	}
+	lex.state = match.next;
+	return true;
+}/*}}}*/
+
+/* Returns the furthest character lookup() had to look at, going from the
+	end of prev to the token in results, or eoi if any of the tokens on the
+	way could still grow with more input. lookup() steps over the skipped
+	tokens itself, so each of them is walked here from its own start and
+	lexer state. If the walk loses track of lookup(), everything up to eoi
+	is assumed. */
+template<typename lexer_type> static typename lexer_type::iter_type
+php_parle_lexer_reach(const lexertl::state_machine &sm, const lexer_type &prev, const lexer_type &results)
+{/*{{{*/
+	auto first = prev.second, reach = first;
+	lexer_type lex(prev);
+
+	while (true) {
+		struct parle_lexer_dfa_match<typename lexer_type::iter_type> match{first, 0, lex.state, lexer_type::npos(), false};
+
+		reach = std::max(reach, php_parle_lexer_dfa_reach(sm, lex.state, lex.bol, first, results.eoi, &match));
+		if (reach == results.eoi || first == results.first) {
+			return reach;
+		}
+		if (match.end == first || match.end > results.first || !php_parle_lexer_skip_state(lex, match)) {
+			return results.eoi;
+		}
+		first = match.end;
+		lex.bol = '\n' == *(first - 1);
+	}
+}/*}}}*/
+
+template<typename lexer_obj_type, typename lexer_type> void
+_lexer_feed(INTERNAL_FUNCTION_PARAMETERS, zend_class_entry *ce) noexcept
+{/*{{{*/
+	lexer_obj_type *zplo;
+	zval *me;
+	char *chunk;
+	size_t chunk_len;
+	zend_bool final = 0;
+
+	if(zend_parse_method_parameters(ZEND_NUM_ARGS(), getThis(), "Os|b", &me, ce, &chunk, &chunk_len, &final) == FAILURE) {
+		return;
+	}
+
+	zplo = _php_parle_lexer_fetch_zobj<lexer_obj_type>(Z_OBJ_P(me));
+
+	if (!zplo->complete) {
+		zend_throw_exception(ParleLexerException_ce, "Lexer state machine is not ready", 0);
+		return;
+	}
+
+	array_init(return_value);
+
+	try {
+		/* Keep only the tail which isn't tokenized yet and append the new
+			chunk. The results keep their bol, state and stack, only the
+			iterators are moved to the new buffer. */
+		if (!zplo->in) {
+			zplo->in = new parle_string{};
+			zplo->in_offset = 0;
+		}
+		if (zplo->checkpoints) {
+			delete zplo->checkpoints;
+			zplo->checkpoints = nullptr;
+		}
+		php_parle_lexer_drop_lookahead(zplo);
+		/* The lines in the dropped input are counted on the way, they can't
+			be looked at later. */
+		if (!zplo->lines) {
+			zplo->lines = new parle_line_index{0, 0, {}, zplo->in_offset};
+		}
+		if (zplo->results) {
+			size_t pos = zplo->results->second - zplo->in->cbegin();
+			php_parle_line_index_drop(*zplo->lines, zplo->in->data(), zplo->in_offset, zplo->in_offset + pos);
+			zplo->in->erase(0, pos);
+			zplo->in_offset += pos;
+			/* Still valid if the append below throws. */
+			zplo->results->first = zplo->results->second = zplo->in->cbegin();
+			zplo->results->eoi = zplo->in->cend();
+		}
+		zplo->in->append(chunk, chunk_len);
+		if (!zplo->results) {
+			zplo->results = new lexer_type(zplo->in->cbegin(), zplo->in->cend());
+		}
+		zplo->results->first = zplo->results->second = zplo->in->cbegin();
+		zplo->results->eoi = zplo->in->cend();
+		/* relex() starts over from here. */
+		if (zplo->in_state) {
+			*zplo->in_state = *zplo->results;
+		} else {
+			zplo->in_state = new lexer_type(*zplo->results);
+		}
+
+		lexer_type prev = *zplo->results;
+
+		while (true) {
+			lexertl::lookup(*zplo->sm, *zplo->results);
+
+			if (!final && (zplo->results->second == zplo->results->eoi ||
+				php_parle_lexer_reach(*zplo->sm, prev, *zplo->results) == zplo->results->eoi)) {
+				/* The match could still change with the next chunk, wait for
+					it. This includes the skipped tokens before it. */
+				*zplo->results = prev;
+				break;
+			}
+
+			if (zplo->results->id == zplo->sm->eoi()) {
+				break;
+			}
+
+			if (!zplo->filter || !zplo->filter->has(zplo->results->id)) {
+				zval tok;
+				size_t offset = zplo->in_offset + (zplo->results->first - zplo->in->cbegin());
+				php_parle_token_init(&tok, static_cast<zend_long>(zplo->results->id), &*zplo->results->first,
+					zplo->results->second - zplo->results->first, offset);
+				php_parle_lexer_token_position(zplo, &tok, offset);
+				add_next_index_zval(return_value, &tok);
+			}
+
+			prev = *zplo->results;
+		}
+	} catch (const std::exception &e) {
+		zend_throw_exception(ParleLexerException_ce, e.what(), 0);
+	}
+}/*}}}*/
+
+/* {{{ public array Lexer::feed(string $chunk [, bool $final = false]) */
+PHP_METHOD(ParleLexer, feed)
+{
+	_lexer_feed<struct ze_parle_lexer_obj, parle_smatch>(INTERNAL_FUNCTION_PARAM_PASSTHRU, ParleLexer_ce);
+}
+/* }}} */
+
+/* {{{ public array RLexer::feed(string $chunk [, bool $final = false]) */
+PHP_METHOD(ParleRLexer, feed)
+{
+	_lexer_feed<struct ze_parle_rlexer_obj, parle_srmatch>(INTERNAL_FUNCTION_PARAM_PASSTHRU, ParleRLexer_ce);
+}
+/* }}} */
+
+/* Distance in bytes between two lexer checkpoints, see relex(). */
+#define PARLE_CHECKPOINT_INTERVAL 1024
+
+static zend_always_inline bool
+php_parle_lexer_same_state(const parle_smatch &a, const parle_smatch &b) noexcept
+{/*{{{*/
+	return a.state == b.state && a.bol == b.bol;
+}/*}}}*/
+
+static zend_always_inline bool
+php_parle_lexer_same_state(const parle_srmatch &a, const parle_srmatch &b) noexcept
+{/*{{{*/
+	return a.state == b.state && a.bol == b.bol && a.stack == b.stack;
+}/*}}}*/
+
+/* Lex in starting at the given checkpoint and record a new checkpoint at
+	the first token boundary after each PARLE_CHECKPOINT_INTERVAL bytes.
+	With old checkpoints passed, stop at the first boundary from sync_from
+	on, which matches an old checkpoint moved by delta with the same lexer
+	state. Everything after it lexes the same as before. Returns the index
+	of that old checkpoint or old->size(), end receives the offset and
+	reach how far the tokens up to there looked ahead. The offsets are into
+	in, the tokens get theirs within the stream, which in starts at
+	in_offset of. */
+template<typename lexer_type> static size_t
+php_parle_lexer_scan(const lexertl::state_machine &sm, const parle_string &in, const struct parle_lexer_checkpoint<lexer_type> &start,
+	parle_vector<struct parle_lexer_checkpoint<lexer_type>> &cps, const parle_vector<struct parle_lexer_checkpoint<lexer_type>> *old,
+	size_t old_idx, size_t sync_from, ptrdiff_t delta, const struct parle_id_filter *filter, zval *tokens, struct parle_line_index *lines,
+	size_t in_offset, size_t &end, size_t &reach)
+{/*{{{*/
+	const auto begin = in.cbegin();
+	lexer_type results(start.results);
+	size_t last_cp = start.offset;
+
+	reach = start.reach;
+
+	results.first = results.second = begin + start.offset;
+	results.eoi = in.cend();
+
+	lexer_type prev = results;
+
+	while (true) {
+		lexertl::lookup(sm, results);
+
+		/* Track how far the tokens looked ahead, an edit there invalidates them. */
+		reach = std::max(reach, static_cast<size_t>(php_parle_lexer_reach(sm, prev, results) - begin) + 1);
+
+		if (results.id == sm.eoi()) {
+			break;
+		}
+
+		if (tokens && (!filter || !filter->has(results.id))) {
+			zval tok;
+			php_parle_token_init(&tok, static_cast<zend_long>(results.id), &*results.first, results.second - results.first, in_offset + (results.first - begin));
+			if (lines) {
+				php_parle_token_position(&tok, *lines, in.data(), in_offset, in_offset + (results.first - begin));
+			}
+			add_next_index_zval(tokens, &tok);
+		}
+
+		size_t b = results.second - begin;
+
+		if (old && b >= sync_from) {
+			while (old_idx < old->size() && static_cast<ptrdiff_t>((*old)[old_idx].offset) + delta < static_cast<ptrdiff_t>(b)) {
+				old_idx++;
+			}
+			if (old_idx < old->size() && static_cast<ptrdiff_t>((*old)[old_idx].offset) + delta == static_cast<ptrdiff_t>(b) &&
+				php_parle_lexer_same_state((*old)[old_idx].results, results)) {
+				end = b;
+				return old_idx;
+			}
+		}
+
+		if (b >= last_cp + PARLE_CHECKPOINT_INTERVAL) {
+			cps.push_back(parle_lexer_checkpoint<lexer_type>{b, reach, results});
+			last_cp = b;
+		}
+
+		prev = results;
+	}
+
+	end = in.size();
+
+	return old ? old->size() : 0;
+}/*}}}*/
+
+/* Put results at the start of in, in the lexer state feed() left there. */
+template<typename lexer_obj_type, typename lexer_type> static void
+php_parle_lexer_in_start(const lexer_obj_type *zplo, lexer_type &results)
+{/*{{{*/
+	if (zplo->in_state) {
+		results = *zplo->in_state;
+		results.id = 0;
+		results.user_id = lexer_type::npos();
+		results.first = results.second = zplo->in->cbegin();
+		results.eoi = zplo->in->cend();
+	} else {
+		results.reset(zplo->in->cbegin(), zplo->in->cend());
+	}
+}/*}}}*/
+
+/* Replace a range of the input and lex it again from the last checkpoint
+	before it, up to where the tokens are the same as before. The pull
+	position of advance() is kept if the current token ends before that
+	checkpoint, otherwise pulling, and feed(), start over at the start of
+	the input. */
+template<typename lexer_obj_type, typename lexer_type> void
+_lexer_relex(INTERNAL_FUNCTION_PARAMETERS, zend_class_entry *ce) noexcept
+{/*{{{*/
+	using cp_vector = parle_vector<struct parle_lexer_checkpoint<lexer_type>>;
+	lexer_obj_type *zplo;
+	zval *me, tokens;
+	zend_long edit_start, old_len;
+	zend_string *new_text;
+
+	if(zend_parse_method_parameters(ZEND_NUM_ARGS(), getThis(), "OllS", &me, ce, &edit_start, &old_len, &new_text) == FAILURE) {
+		return;
+	}
+
+	zplo = _php_parle_lexer_fetch_zobj<lexer_obj_type>(Z_OBJ_P(me));
+
+	if (!zplo->complete) {
+		zend_throw_exception(ParleLexerException_ce, "Lexer state machine is not ready", 0);
+		return;
+	} else if (!zplo->results) {
+		zend_throw_exception(ParleLexerException_ce, "No results available", 0);
+		return;
+	} else if (edit_start < static_cast<zend_long>(zplo->in_offset) || old_len < 0 ||
+		static_cast<size_t>(edit_start) - zplo->in_offset > zplo->in->length() ||
+		static_cast<size_t>(old_len) > zplo->in->length() - (static_cast<size_t>(edit_start) - zplo->in_offset)) {
+		/* The input dropped by feed() can't be edited anymore. */
+		zend_throw_exception_ex(ParleLexerException_ce, 0, "Invalid edit range " ZEND_LONG_FMT ", " ZEND_LONG_FMT, edit_start, old_len);
+		return;
+	}
+
+	try {
+		/* The offsets are within the stream like those of the tokens, the
+			kept input starts at in_offset. */
+		size_t start = static_cast<size_t>(edit_start) - zplo->in_offset, old_end = start + static_cast<size_t>(old_len);
+		size_t new_end = start + ZSTR_LEN(new_text), end, reach;
+		ptrdiff_t delta = static_cast<ptrdiff_t>(ZSTR_LEN(new_text)) - static_cast<ptrdiff_t>(old_len);
+
+		/* The checkpoints are collected with a full pass on the first edit. */
+		if (!zplo->checkpoints) {
+			zplo->checkpoints = new cp_vector{};
+			parle_lexer_checkpoint<lexer_type> cp{0, 0, lexer_type{}};
+			php_parle_lexer_in_start(zplo, cp.results);
+			zplo->checkpoints->push_back(cp);
+			php_parle_lexer_scan(*zplo->sm, *zplo->in, cp, *zplo->checkpoints, static_cast<cp_vector *>(nullptr), 0, 0, 0, nullptr, nullptr, nullptr, 0, end, reach);
+		}
+
+		cp_vector &old = *zplo->checkpoints;
+
+		/* Resume from the last checkpoint before the edit, which tokens
+			didn't look into the edited range. */
+		size_t k = 0;
+		while (k + 1 < old.size() && old[k + 1].offset <= start) {
+			k++;
+		}
+		while (k > 0 && old[k].reach > start) {
+			k--;
+		}
+
+		size_t old_idx = k + 1;
+		while (old_idx < old.size() && old[old_idx].offset < old_end) {
+			old_idx++;
+		}
+
+		/* The tokens before the checkpoint lex the same as before. */
+		bool keep = static_cast<size_t>(zplo->results->second - zplo->in->cbegin()) <= old[k].offset;
+		size_t first = zplo->results->first - zplo->in->cbegin(), second = zplo->results->second - zplo->in->cbegin();
+
+		zplo->in->replace(start, static_cast<size_t>(old_len), ZSTR_VAL(new_text), ZSTR_LEN(new_text));
+		if (zplo->lines) {
+			php_parle_line_index_truncate(*zplo->lines, zplo->in_offset + start);
+		} else {
+			zplo->lines = new parle_line_index{0, 0, {}, zplo->in_offset};
+		}
+
+		cp_vector cps(old.begin(), old.begin() + k + 1);
+		array_init(&tokens);
+		size_t synced = php_parle_lexer_scan(*zplo->sm, *zplo->in, old[k], cps, &old, old_idx, new_end, delta, zplo->filter, &tokens, zplo->lines, zplo->in_offset, end, reach);
+
+		for (size_t i = synced; i < old.size(); i++) {
+			auto cp = old[i];
+			cp.offset += delta;
+			cp.reach = std::max(reach, cp.reach >= old_end ? cp.reach + delta : new_end);
+			reach = cp.reach;
+			cps.push_back(cp);
+		}
+
+		array_init(return_value);
+		add_assoc_long_ex(return_value, "offset", sizeof("offset")-1, static_cast<zend_long>(zplo->in_offset + old[k].offset));
+		add_assoc_long_ex(return_value, "oldEnd", sizeof("oldEnd")-1, static_cast<zend_long>(zplo->in_offset + (synced < old.size() ? old[synced].offset : end - delta)));
+		add_assoc_long_ex(return_value, "end", sizeof("end")-1, static_cast<zend_long>(zplo->in_offset + end));
+		add_assoc_zval_ex(return_value, "tokens", sizeof("tokens")-1, &tokens);
+
+		old.swap(cps);
+
+		if (keep) {
+			zplo->results->first = zplo->in->cbegin() + first;
+			zplo->results->second = zplo->in->cbegin() + second;
+			zplo->results->eoi = zplo->in->cend();
+		} else {
+			php_parle_lexer_in_start(zplo, *zplo->results);
+		}
+		php_parle_lexer_drop_lookahead(zplo);
+	} catch (const std::exception &e) {
+		zend_throw_exception(ParleLexerException_ce, e.what(), 0);
+	}
+}/*}}}*/
+
+/* {{{ public array Lexer::relex(int $editStart, int $oldLen, string $newText) */
+PHP_METHOD(ParleLexer, relex)
 {
-	_lexer_macro<struct ze_parle_lexer_obj>(INTERNAL_FUNCTION_PARAM_PASSTHRU, ParleLexer_ce);
+	_lexer_relex<struct ze_parle_lexer_obj, parle_smatch>(INTERNAL_FUNCTION_PARAM_PASSTHRU, ParleLexer_ce);
 }
 /* }}} */
 
-/* {{{ public void RLexer::insertMacro(string $name, string $reg) */
-PHP_METHOD(ParleRLexer, insertMacro)
+/* {{{ public array RLexer::relex(int $editStart, int $oldLen, string $newText) */
+PHP_METHOD(ParleRLexer, relex)
 {
-	_lexer_macro<struct ze_parle_rlexer_obj>(INTERNAL_FUNCTION_PARAM_PASSTHRU, ParleRLexer_ce);
+	_lexer_relex<struct ze_parle_rlexer_obj, parle_srmatch>(INTERNAL_FUNCTION_PARAM_PASSTHRU, ParleRLexer_ce);
 }
 /* }}} */
 
-template<typename lexer_obj_type> void
-_lexer_dump(INTERNAL_FUNCTION_PARAMETERS, zend_class_entry *ce) noexcept
-{/*{{{*/
-	lexer_obj_type *zplo;
+/* {{{ public array Lexer::tokenizeParallel(string $in, int $threads) */
+PHP_METHOD(ParleLexer, tokenizeParallel)
+{
+	struct ze_parle_lexer_obj *zplo;
 	zval *me;
+	zend_string *in;
+	zend_long threads;
 
-	if(zend_parse_method_parameters(ZEND_NUM_ARGS(), getThis(), "O", &me, ce) == FAILURE) {
+	if(zend_parse_method_parameters(ZEND_NUM_ARGS(), getThis(), "OSl", &me, ParleLexer_ce, &in, &threads) == FAILURE) {
 		return;
 	}
 
-	zplo = _php_parle_lexer_fetch_zobj<lexer_obj_type>(Z_OBJ_P(me));
+	zplo = php_parle_lexer_fetch_obj(Z_OBJ_P(me));
 
 	if (!zplo->complete) {
 		zend_throw_exception(ParleLexerException_ce, "Lexer state machine is not ready", 0);
 		return;
+	} else if (threads < 1) {
+		zend_throw_exception_ex(ParleLexerException_ce, 0, "Invalid thread count " ZEND_LONG_FMT, threads);
+		return;
 	}
 
+	array_init(return_value);
+
 	try {
-		/* XXX std::cout might be not thread safe, need to gather the right
-			descriptor from the SAPI and convert to a usable stream. */
-		lexertl::debug::dump(*zplo->sm, *zplo->rules, std::cout);
+		const char *str = ZSTR_VAL(in);
+		struct parle_line_index lines{0, 0, {}, 0};
+
+		php_parle_lexer_lex_parallel(*zplo->sm, str, ZSTR_LEN(in), static_cast<size_t>(threads), [&](const struct parle_span_token &tok) {
+			if (!zplo->filter || !zplo->filter->has(tok.id)) {
+				zval ztok;
+				php_parle_token_init(&ztok, static_cast<zend_long>(tok.id), str + tok.first, tok.second - tok.first, static_cast<zend_long>(tok.first));
+				php_parle_token_position(&ztok, lines, str, 0, tok.first);
+				add_next_index_zval(return_value, &ztok);
+			}
+		});
 	} catch (const std::exception &e) {
 		zend_throw_exception(ParleLexerException_ce, e.what(), 0);
 	}
 }
 /* }}} */
 
-/* {{{ public void Lexer::dump(void) */
-PHP_METHOD(ParleLexer, dump)
-{
-	_lexer_dump<struct ze_parle_lexer_obj>(INTERNAL_FUNCTION_PARAM_PASSTHRU, ParleLexer_ce);
-}
-/* }}} */
+/* Run the push mode automaton until the lookahead is shifted or there's
+	a reduce, accept or error for the caller to handle. */
+static void
+php_parle_parser_push_run(struct ze_parle_parser_obj *zppo)
+{/*{{{*/
+	const parsertl::state_machine &sm = *zppo->sm;
+	parsertl::match_results &results = *zppo->results;
+	struct parle_parser_push &push = *zppo->push;
 
-/* {{{ public void RLexer::dump(void) */
-PHP_METHOD(ParleRLexer, dump)
-{
-	_lexer_dump<struct ze_parle_rlexer_obj>(INTERNAL_FUNCTION_PARAM_PASSTHRU, ParleRLexer_ce);
-}
-/* }}} */
+	while (true) {
+		switch (results.entry.action) {
+			case parsertl::shift:
+				results.stack.push_back(results.entry.param);
+				push.productions.push_back(push.token);
+				if (push.token.id != 0) {
+					push.need_token = true;
+					return;
+				}
+				/* End of input stays the lookahead, like in parsertl::lookup(). */
+				results.entry = sm._table[results.stack.back() * sm._columns + results.token_id];
+				break;
+			case parsertl::go_to:
+				results.stack.push_back(results.entry.param);
+				results.token_id = push.token.id;
+				results.entry = sm._table[results.stack.back() * sm._columns + results.token_id];
+				break;
+			default:
+				return;
+		}
+	}
+}/*}}}*/
+
+static void
+php_parle_parser_push_advance(struct ze_parle_parser_obj *zppo)
+{/*{{{*/
+	const parsertl::state_machine &sm = *zppo->sm;
+	parsertl::match_results &results = *zppo->results;
+	struct parle_parser_push &push = *zppo->push;
+
+	if (push.need_token) {
+		return;
+	}
+
+	if (results.entry.action == parsertl::reduce) {
+		const size_t size = sm._rules[results.entry.param].second.size();
+		struct parle_push_production prod;
+
+		if (size) {
+			prod.first = (push.productions.end() - size)->first;
+			prod.second = push.productions.back().second;
+			results.stack.resize(results.stack.size() - size);
+			push.productions.resize(push.productions.size() - size);
+		} else {
+			prod.first = prod.second = push.token.first;
+		}
+
+		results.token_id = sm._rules[results.entry.param].first;
+		results.entry = sm._table[results.stack.back() * sm._columns + results.token_id];
+		prod.id = results.token_id;
+		push.productions.push_back(prod);
+	}
+
+	php_parle_parser_push_run(zppo);
+}/*}}}*/
+
+static void
+php_parle_parser_push_token(struct ze_parle_parser_obj *zppo, size_t id, const char *val, size_t val_len)
+{/*{{{*/
+	const parsertl::state_machine &sm = *zppo->sm;
+	parsertl::match_results &results = *zppo->results;
+	struct parle_parser_push &push = *zppo->push;
+
+	/* Drop the values nothing refers to anymore. The productions on the
+		stack are ordered, so the first one starts the live part. */
+	size_t keep = push.productions.empty() ? push.buf.size() : push.productions.front().first;
+	if (keep >= 4096 && keep >= push.buf.size() / 2) {
+		push.buf.erase(0, keep);
+		push.buf_offset += keep;
+		for (auto &prod : push.productions) {
+			prod.first -= keep;
+			prod.second -= keep;
+		}
+	}
+
+	push.token.id = id;
+	push.token.first = push.buf.size();
+	push.buf.append(val, val_len);
+	push.token.second = push.buf.size();
+	push.need_token = false;
+
+	results.token_id = id;
+	/* The columns after the terminals are the gotos of the non-terminals. */
+	if (id >= zppo->rules->tokens_info().size()) {
+		results.entry.action = parsertl::error;
+		results.entry.param = parsertl::unknown_token;
+		return;
+	}
+	results.entry = sm._table[results.stack.back() * sm._columns + id];
+
+	php_parle_parser_push_run(zppo);
+}/*}}}*/
 
 /* {{{ public void Parser::token(string $token) */
 PHP_METHOD(ParleParser, token)
@@ -751,13 +2746,80 @@ PHP_METHOD(ParleParser, nonassoc)
 }
 /* }}} */
 
-/* {{{ public void Parser::build(void) */
+/* Skip the reductions of the unit productions A: X not in keep. A shift
+	or goto on X into a state, which does nothing but reduce A: X, is sent
+	to the state the goto on A leads to right away. Only done when that
+	state rejects the same lookaheads, so just these reductions vanish and
+	the parse is otherwise the same. */
+static void
+php_parle_parser_skip_units(parsertl::state_machine &sm, size_t terminals, const std::vector<bool> &keep)
+{/*{{{*/
+	const size_t npos = ~static_cast<size_t>(0);
+	const size_t cols = sm._columns;
+	std::vector<size_t> unit(sm._rows, npos);
+
+	for (size_t q = 0; q < sm._rows; q++) {
+		const auto *row = &sm._table[q * cols];
+		size_t prod = npos;
+		bool only = true;
+
+		for (size_t c = 0; c < cols && only; c++) {
+			if (row[c].action == parsertl::error) {
+				continue;
+			} else if (c >= terminals || row[c].action != parsertl::reduce || (prod != npos && row[c].param != prod)) {
+				only = false;
+			} else {
+				prod = row[c].param;
+			}
+		}
+		if (only && prod != npos && sm._rules[prod].second.size() == 1 && !(prod < keep.size() && keep[prod])) {
+			unit[q] = prod;
+		}
+	}
+
+	/* Chains like exp: term, term: factor take a pass per link. Cyclic
+		unit productions can't lead anywhere, but bound it anyway. */
+	bool changed = true;
+	for (size_t pass = 0; changed && pass < sm._rows; pass++) {
+		changed = false;
+		for (size_t p = 0; p < sm._rows; p++) {
+			for (size_t c = 0; c < cols; c++) {
+				auto &e = sm._table[p * cols + c];
+
+				if ((e.action != parsertl::shift && e.action != parsertl::go_to) || unit[e.param] == npos) {
+					continue;
+				}
+
+				const size_t q = e.param;
+				const auto &g = sm._table[p * cols + sm._rules[unit[q]].first];
+
+				if (g.action != parsertl::go_to) {
+					continue;
+				}
+
+				const size_t r = g.param;
+				bool same = true;
+
+				for (size_t t = 0; t < terminals && same; t++) {
+					const auto &qe = sm._table[q * cols + t], &re = sm._table[r * cols + t];
+					same = qe.action != parsertl::error || (re.action == parsertl::error && re.param == qe.param);
+				}
+				if (same) {
+					e.param = r;
+					changed = true;
+				}
+			}
+		}
+	}
+}/*}}}*/
+
+/* {{{ public void Parser::build([array $unitActions]) */
 PHP_METHOD(ParleParser, build)
 {
 	struct ze_parle_parser_obj *zppo;
-	zval *me;
+	zval *me, *unit_actions = nullptr, *id;
 
-	if(zend_parse_method_parameters(ZEND_NUM_ARGS(), getThis(), "O", &me, ParleParser_ce) == FAILURE) {
+	if(zend_parse_method_parameters(ZEND_NUM_ARGS(), getThis(), "O|a!", &me, ParleParser_ce, &unit_actions) == FAILURE) {
 		return;
 	}
 
@@ -770,6 +2832,18 @@ PHP_METHOD(ParleParser, build)
 
 	try {
 		parsertl::generator::build(*zppo->rules, *zppo->sm);
+		/* Unit productions missing from the list have no action and are
+			never reported as reduced. */
+		if (unit_actions) {
+			std::vector<bool> keep(zppo->sm->_rules.size(), false);
+			ZEND_HASH_FOREACH_VAL(Z_ARRVAL_P(unit_actions), id) {
+				zend_long prod = zval_get_long(id);
+				if (prod >= 0 && static_cast<size_t>(prod) < keep.size()) {
+					keep[prod] = true;
+				}
+			} ZEND_HASH_FOREACH_END();
+			php_parle_parser_skip_units(*zppo->sm, zppo->rules->tokens_info().size(), keep);
+		}
 	} catch (const std::exception &e) {
 		zend_throw_exception(ParleParserException_ce, e.what(), 0);
 	}
@@ -829,12 +2903,391 @@ PHP_METHOD(ParleParser, validate)
 	}
 
 	try {
-		lexertl::citerator iter(ZSTR_VAL(in), ZSTR_VAL(in) + ZSTR_LEN(in), *zplo->sm);
+		parle_citerator iter(ZSTR_VAL(in), ZSTR_VAL(in) + ZSTR_LEN(in), *zplo->sm, zplo->filter);
 		
 		/* Since it's not more than parse, nothing is saved into the object. */
 		parsertl::match_results results(iter->id, *zppo->sm);
 
-		RETURN_BOOL(parsertl::parse(*zppo->sm, iter, results));
+		RETURN_BOOL(parsertl::parse(*zppo->sm, iter, results));
+	} catch (const std::exception &e) {
+		zend_throw_exception(ParleParserException_ce, e.what(), 0);
+	}
+
+	RETURN_FALSE
+}
+/* }}} */
+
+/* Run the parser over one input, collecting the ids of the reductions if
+	asked for. Touches no engine state, so it's fine on a pool thread. */
+static bool
+php_parle_parser_run(const parsertl::state_machine &sm, const lexertl::state_machine &lex_sm, const parle_id_filter *filter,
+	const char *in, size_t len, parsertl::match_results &results, std::vector<size_t> *reduced)
+{/*{{{*/
+	parle_citerator iter(in, in + len, lex_sm, filter);
+
+	results.reset(iter->id, sm);
+
+	if (!reduced) {
+		return parsertl::parse(sm, iter, results);
+	}
+
+	reduced->clear();
+	while (results.entry.action != parsertl::error && results.entry.action != parsertl::accept) {
+		if (results.entry.action == parsertl::reduce) {
+			reduced->push_back(results.entry.param);
+		}
+		parsertl::lookup(sm, iter, results);
+	}
+
+	return results.entry.action == parsertl::accept;
+}/*}}}*/
+
+/* Run the parser over each of the inputs, either only validating them or
+	also collecting the ids of the reductions. The match results and the
+	reductions vector are reused. The results are keyed like the inputs.
+	With more than one thread the inputs are split into contiguous blocks
+	that run on the pool, the PHP values are only built afterwards. */
+static void
+_parser_many(INTERNAL_FUNCTION_PARAMETERS, bool reductions) noexcept
+{/*{{{*/
+	struct ze_parle_parser_obj *zppo;
+	struct ze_parle_lexer_obj *zplo;
+	zval *me, *inputs, *lex, *input;
+	zend_string *key;
+	zend_ulong idx;
+	zend_long threads = 1;
+
+	if(zend_parse_method_parameters(ZEND_NUM_ARGS(), getThis(), "OaO|l", &me, ParleParser_ce, &inputs, &lex, ParleLexer_ce, &threads) == FAILURE) {
+		return;
+	}
+
+	zppo = php_parle_parser_fetch_obj(Z_OBJ_P(me));
+	zplo = php_parle_lexer_fetch_obj(Z_OBJ_P(lex));
+
+	if (!zppo->complete) {
+		zend_throw_exception(ParleParserException_ce, "Parser state machine is not ready", 0);
+		return;
+	}
+	if (!zplo->complete) {
+		zend_throw_exception(ParleParserException_ce, "Lexer state machine is not ready", 0);
+		return;
+	}
+	if (threads < 1) {
+		zend_throw_exception_ex(ParleParserException_ce, 0, "Invalid thread count " ZEND_LONG_FMT, threads);
+		return;
+	}
+
+	array_init_size(return_value, zend_hash_num_elements(Z_ARRVAL_P(inputs)));
+
+	auto add = [return_value](zend_string *key, zend_ulong idx, bool ok, const std::vector<size_t> *reduced) {
+		zval ret;
+
+		if (ok && reduced) {
+			array_init_size(&ret, reduced->size());
+			for (size_t id : *reduced) {
+				add_next_index_long(&ret, static_cast<zend_long>(id));
+			}
+		} else {
+			ZVAL_BOOL(&ret, ok);
+		}
+
+		if (key) {
+			zend_hash_update(Z_ARRVAL_P(return_value), key, &ret);
+		} else {
+			zend_hash_index_update(Z_ARRVAL_P(return_value), idx, &ret);
+		}
+	};
+
+	const parsertl::state_machine &sm = *zppo->sm;
+	const lexertl::state_machine &lex_sm = *zplo->sm;
+	const size_t n = zend_hash_num_elements(Z_ARRVAL_P(inputs));
+
+	/* A lazily built lexer DFA grows while lexing, so it can't be shared. */
+	if (threads == 1 || n < 2 || lex_sm.data()._lazy) {
+		try {
+			parsertl::match_results results;
+			std::vector<size_t> reduced;
+
+			ZEND_HASH_FOREACH_KEY_VAL(Z_ARRVAL_P(inputs), idx, key, input) {
+				zend_string *in = zval_get_string(input);
+				bool ok = php_parle_parser_run(sm, lex_sm, zplo->filter, ZSTR_VAL(in), ZSTR_LEN(in), results, reductions ? &reduced : nullptr);
+
+				zend_string_release(in);
+				add(key, idx, ok, reductions ? &reduced : nullptr);
+			} ZEND_HASH_FOREACH_END();
+		} catch (const std::exception &e) {
+			zend_throw_exception(ParleParserException_ce, e.what(), 0);
+		}
+		return;
+	}
+
+	struct item {
+		zend_string *key;
+		zend_ulong idx;
+		zend_string *in;
+		bool ok;
+		std::vector<size_t> reduced;
+	};
+	std::vector<struct item> items;
+
+	items.reserve(n);
+	ZEND_HASH_FOREACH_KEY_VAL(Z_ARRVAL_P(inputs), idx, key, input) {
+		items.push_back(item{key, idx, zval_get_string(input), false, {}});
+	} ZEND_HASH_FOREACH_END();
+
+	const size_t blocks = std::min(static_cast<size_t>(threads), n);
+	std::vector<std::string> errors(blocks);
+
+	php_parle_thread_pool().run(blocks, [&](size_t b) {
+		try {
+			parsertl::match_results results;
+
+			for (size_t i = n * b / blocks; i < n * (b + 1) / blocks; i++) {
+				struct item &it = items[i];
+
+				it.ok = php_parle_parser_run(sm, lex_sm, zplo->filter, ZSTR_VAL(it.in), ZSTR_LEN(it.in), results, reductions ? &it.reduced : nullptr);
+			}
+		} catch (const std::exception &e) {
+			errors[b] = e.what();
+		} catch (...) {
+			errors[b] = "Unknown error";
+		}
+	});
+
+	for (auto &it : items) {
+		add(it.key, it.idx, it.ok, reductions ? &it.reduced : nullptr);
+		zend_string_release(it.in);
+	}
+
+	for (auto &err : errors) {
+		if (!err.empty()) {
+			zend_throw_exception(ParleParserException_ce, err.c_str(), 0);
+			break;
+		}
+	}
+}/*}}}*/
+
+/* {{{ public array Parser::validateMany(array $inputs, Lexer $lex [, int $threads = 1]) */
+PHP_METHOD(ParleParser, validateMany)
+{
+	_parser_many(INTERNAL_FUNCTION_PARAM_PASSTHRU, false);
+}
+/* }}} */
+
+/* {{{ public array Parser::parseMany(array $inputs, Lexer $lex [, int $threads = 1]) */
+PHP_METHOD(ParleParser, parseMany)
+{
+	_parser_many(INTERNAL_FUNCTION_PARAM_PASSTHRU, true);
+}
+/* }}} */
+
+/* Parse in from the start snapshot, recording a snapshot at the first
+	shift after each PARLE_CHECKPOINT_INTERVAL bytes. From sync_from on,
+	stop at a shift ending where an old snapshot moved by delta is, with
+	the same lexer state and parse stack. The rest of the parse is the same
+	as before then. Returns the index of that old snapshot or old.size(),
+	valid receives the result of a parse that ran to the end. The ids of
+	the reductions on the way are collected if asked for, stop receives
+	the offset the scan ended at. */
+static size_t
+php_parle_parser_reparse_scan(const parsertl::state_machine &sm, size_t terminals, const lexertl::state_machine &lex_sm, const parle_string &in,
+	const struct parle_parser_snapshot &start, parle_vector<struct parle_parser_snapshot> &snaps,
+	const parle_vector<struct parle_parser_snapshot> &old, size_t old_idx, size_t sync_from, ptrdiff_t delta,
+	const struct parle_id_filter *filter, std::vector<size_t> *reduced, bool &valid, size_t &reach, size_t &stop)
+{/*{{{*/
+	const auto begin = in.cbegin();
+	parle_smatch lex(start.lex.results);
+	parsertl::match_results results;
+	size_t last_cp = start.lex.offset;
+
+	reach = start.lex.reach;
+	lex.first = lex.second = begin + start.lex.offset;
+	lex.eoi = in.cend();
+	results.stack.assign(start.stack.begin(), start.stack.end());
+
+	while (true) {
+		parle_smatch prev = lex;
+
+		do {
+			lexertl::lookup(lex_sm, lex);
+			reach = std::max(reach, static_cast<size_t>(php_parle_lexer_reach(lex_sm, prev, lex) - begin) + 1);
+			prev = lex;
+		} while (filter && lex.first != lex.eoi && filter->has(lex.id));
+
+		if (lex.id == parle_smatch::npos() || lex.id >= terminals) {
+			valid = false;
+			stop = lex.first - begin;
+			return old.size();
+		}
+
+		results.token_id = lex.id;
+		results.entry = sm._table[results.stack.back() * sm._columns + results.token_id];
+
+		/* Same as parsertl::parse() up to the next shift. */
+		while (true) {
+			switch (results.entry.action) {
+				case parsertl::shift:
+					results.stack.push_back(results.entry.param);
+					if (results.token_id != 0) {
+						break;
+					}
+					results.entry = sm._table[results.stack.back() * sm._columns + results.token_id];
+					continue;
+				case parsertl::reduce:
+					if (reduced) {
+						reduced->push_back(results.entry.param);
+					}
+					results.stack.resize(results.stack.size() - sm._rules[results.entry.param].second.size());
+					results.token_id = sm._rules[results.entry.param].first;
+					results.entry = sm._table[results.stack.back() * sm._columns + results.token_id];
+					continue;
+				case parsertl::go_to:
+					results.stack.push_back(results.entry.param);
+					results.token_id = lex.id;
+					results.entry = sm._table[results.stack.back() * sm._columns + results.token_id];
+					continue;
+				case parsertl::accept:
+					valid = true;
+					stop = lex.first - begin;
+					return old.size();
+				default:
+					valid = false;
+					stop = lex.first - begin;
+					return old.size();
+			}
+			break;
+		}
+
+		size_t b = lex.second - begin;
+
+		if (b >= sync_from) {
+			while (old_idx < old.size() && static_cast<ptrdiff_t>(old[old_idx].lex.offset) + delta < static_cast<ptrdiff_t>(b)) {
+				old_idx++;
+			}
+			if (old_idx < old.size() && static_cast<ptrdiff_t>(old[old_idx].lex.offset) + delta == static_cast<ptrdiff_t>(b) &&
+				php_parle_lexer_same_state(old[old_idx].lex.results, lex) && old[old_idx].stack.size() == results.stack.size() &&
+				std::equal(results.stack.begin(), results.stack.end(), old[old_idx].stack.begin())) {
+				stop = b;
+				return old_idx;
+			}
+		}
+
+		if (b >= last_cp + PARLE_CHECKPOINT_INTERVAL) {
+			snaps.push_back(parle_parser_snapshot{{b, reach, lex}, parle_vector<size_t>(results.stack.begin(), results.stack.end())});
+			last_cp = b;
+		}
+	}
+}/*}}}*/
+
+/* {{{ public boolean Parser::reparse(int $editStart, int $oldLen, string $newText, Lexer $lex [, array &$reductions]) */
+PHP_METHOD(ParleParser, reparse)
+{
+	struct ze_parle_parser_obj *zppo;
+	struct ze_parle_lexer_obj *zplo;
+	zval *me, *lex, *reductions = NULL;
+	zend_long edit_start, old_len;
+	zend_string *new_text;
+
+	if(zend_parse_method_parameters(ZEND_NUM_ARGS(), getThis(), "OllSO|z", &me, ParleParser_ce, &edit_start, &old_len, &new_text, &lex, ParleLexer_ce, &reductions) == FAILURE) {
+		return;
+	}
+
+	zppo = php_parle_parser_fetch_obj(Z_OBJ_P(me));
+	zplo = php_parle_lexer_fetch_obj(Z_OBJ_P(lex));
+
+	if (!zppo->complete) {
+		zend_throw_exception(ParleParserException_ce, "Parser state machine is not ready", 0);
+		return;
+	}
+	if (!zplo->complete) {
+		zend_throw_exception(ParleParserException_ce, "Lexer state machine is not ready", 0);
+		return;
+	}
+
+	try {
+		/* The document starts out empty, the first call inserts it. */
+		if (!zppo->reparse) {
+			zppo->reparse = new parle_parser_reparse{parle_string{}, {}, nullptr, nullptr, false};
+		}
+
+		struct parle_parser_reparse &rp = *zppo->reparse;
+
+		if (edit_start < 0 || old_len < 0 || static_cast<size_t>(edit_start) > rp.in.length() ||
+			static_cast<size_t>(old_len) > rp.in.length() - static_cast<size_t>(edit_start)) {
+			zend_throw_exception_ex(ParleParserException_ce, 0, "Invalid edit range " ZEND_LONG_FMT ", " ZEND_LONG_FMT, edit_start, old_len);
+			return;
+		}
+
+		if (rp.lex_sm != zplo->sm || (rp.filter ? !zplo->filter || !(*rp.filter == *zplo->filter) : !!zplo->filter)) {
+			rp.snapshots.clear();
+			rp.snapshots.push_back(parle_parser_snapshot{{0, 0, parle_smatch{}}, {0}});
+			php_parle_shared_release(rp.lex_sm);
+			rp.lex_sm = php_parle_shared_addref(zplo->sm);
+			delete rp.filter;
+			rp.filter = zplo->filter ? new parle_id_filter(*zplo->filter) : nullptr;
+		}
+
+		size_t start = static_cast<size_t>(edit_start), old_end = start + static_cast<size_t>(old_len);
+		size_t new_end = start + ZSTR_LEN(new_text), reach;
+		ptrdiff_t delta = static_cast<ptrdiff_t>(ZSTR_LEN(new_text)) - static_cast<ptrdiff_t>(old_len);
+		parle_vector<struct parle_parser_snapshot> &old = rp.snapshots;
+
+		/* Resume from the last snapshot before the edit, which tokens didn't
+			look into the edited range. */
+		size_t k = 0;
+		while (k + 1 < old.size() && old[k + 1].lex.offset <= start) {
+			k++;
+		}
+		while (k > 0 && old[k].lex.reach > start) {
+			k--;
+		}
+
+		size_t old_idx = k + 1;
+		while (old_idx < old.size() && old[old_idx].lex.offset < old_end) {
+			old_idx++;
+		}
+
+		rp.in.replace(start, static_cast<size_t>(old_len), ZSTR_VAL(new_text), ZSTR_LEN(new_text));
+
+		parle_vector<struct parle_parser_snapshot> snaps(old.begin(), old.begin() + k + 1);
+		std::vector<size_t> reduced;
+		size_t restart = old[k].lex.offset, stop;
+		bool valid;
+		size_t synced = php_parle_parser_reparse_scan(*zppo->sm, zppo->rules->tokens_info().size(), *zplo->sm, rp.in, old[k], snaps, old, old_idx, new_end, delta,
+			rp.filter, reductions ? &reduced : nullptr, valid, reach, stop);
+
+		if (synced < old.size()) {
+			valid = rp.valid;
+			for (size_t i = synced; i < old.size(); i++) {
+				auto snap = old[i];
+				snap.lex.offset += delta;
+				snap.lex.reach = std::max(reach, snap.lex.reach >= old_end ? snap.lex.reach + delta : new_end);
+				reach = snap.lex.reach;
+				snaps.push_back(std::move(snap));
+			}
+		}
+
+		old.swap(snaps);
+		rp.valid = valid;
+
+		/* Only the range parsed again is reported, the reductions before
+			and after it are the same as in the previous parse. */
+		if (reductions) {
+			zval ids;
+
+			ZVAL_DEREF(reductions);
+			zval_ptr_dtor(reductions);
+			array_init_size(reductions, 3);
+			add_assoc_long_ex(reductions, "start", sizeof("start")-1, static_cast<zend_long>(restart));
+			add_assoc_long_ex(reductions, "end", sizeof("end")-1, static_cast<zend_long>(stop));
+			array_init_size(&ids, reduced.size());
+			for (size_t id : reduced) {
+				add_next_index_long(&ids, static_cast<zend_long>(id));
+			}
+			add_assoc_zval_ex(reductions, "reductions", sizeof("reductions")-1, &ids);
+		}
+
+		RETURN_BOOL(valid);
 	} catch (const std::exception &e) {
 		zend_throw_exception(ParleParserException_ce, e.what(), 0);
 	}
@@ -941,6 +3394,21 @@ PHP_METHOD(ParleParser, sigil)
 		return;
 	}
 
+	if (zppo->push) {
+		if (idx < 0 || zppo->push->productions.size() <= static_cast<size_t>(idx)) {
+			zend_throw_exception(ParleParserException_ce, "Invalid index", 0);
+			return;
+		}
+
+		try {
+			auto ret = zppo->results->dollar(*zppo->sm, static_cast<size_t>(idx), zppo->push->productions);
+			RETURN_STRINGL(zppo->push->buf.c_str() + ret.first, ret.second - ret.first);
+		} catch (const std::exception &e) {
+			zend_throw_exception(ParleParserException_ce, e.what(), 0);
+		}
+		return;
+	}
+
 	if (idx < 0 || zppo->productions->size() <= static_cast<size_t>(idx)) {
 		zend_throw_exception(ParleParserException_ce, "Invalid index", 0);
 		return;
@@ -978,7 +3446,107 @@ PHP_METHOD(ParleParser, advance)
 	}
 
 	try {
-		parsertl::lookup(*zppo->sm, *zppo->iter, *zppo->results, *zppo->productions);
+		if (zppo->push) {
+			php_parle_parser_push_advance(zppo);
+		} else {
+			parsertl::lookup(*zppo->sm, *zppo->iter, *zppo->results, *zppo->productions);
+		}
+	} catch (const std::exception &e) {
+		zend_throw_exception(ParleParserException_ce, e.what(), 0);
+	}
+}
+/* }}} */
+
+/* {{{ public int Parser::advanceUntil(array $reduceIds) */
+PHP_METHOD(ParleParser, advanceUntil)
+{
+	struct ze_parle_parser_obj *zppo;
+	zval *me, *reduce_ids, *id;
+
+	if(zend_parse_method_parameters(ZEND_NUM_ARGS(), getThis(), "Oa", &me, ParleParser_ce, &reduce_ids) == FAILURE) {
+		return;
+	}
+
+	zppo = php_parle_parser_fetch_obj(Z_OBJ_P(me));
+
+	if (!zppo->complete) {
+		zend_throw_exception(ParleParserException_ce, "Parser state machine is not ready", 0);
+		return;
+	} else if (!zppo->results) {
+		zend_throw_exception(ParleParserException_ce, "No results available", 0);
+		return;
+	}
+
+	try {
+		struct parle_id_filter ids;
+		ZEND_HASH_FOREACH_VAL(Z_ARRVAL_P(reduce_ids), id) {
+			ids.insert(static_cast<size_t>(zval_get_long(id)));
+		} ZEND_HASH_FOREACH_END();
+
+		parsertl::match_results &results = *zppo->results;
+
+		/* Step at least once like advance(), then on until something the
+			caller wants to see. In push mode also stop for the next token. */
+		do {
+			if (zppo->push) {
+				php_parle_parser_push_advance(zppo);
+				if (zppo->push->need_token) {
+					break;
+				}
+			} else {
+				parsertl::lookup(*zppo->sm, *zppo->iter, results, *zppo->productions);
+			}
+		} while (results.entry.action != parsertl::error && results.entry.action != parsertl::accept &&
+			(results.entry.action != parsertl::reduce || !ids.has(results.entry.param)));
+
+		RETURN_LONG(results.entry.action);
+	} catch (const std::exception &e) {
+		zend_throw_exception(ParleParserException_ce, e.what(), 0);
+	}
+}
+/* }}} */
+
+/* {{{ public int Parser::pushToken(int $id [, string $value]) */
+PHP_METHOD(ParleParser, pushToken)
+{
+	struct ze_parle_parser_obj *zppo;
+	zval *me;
+	zend_long id;
+	zend_string *val = NULL;
+
+	if(zend_parse_method_parameters(ZEND_NUM_ARGS(), getThis(), "Ol|S!", &me, ParleParser_ce, &id, &val) == FAILURE) {
+		return;
+	}
+
+	zppo = php_parle_parser_fetch_obj(Z_OBJ_P(me));
+
+	if (!zppo->complete) {
+		zend_throw_exception(ParleParserException_ce, "Parser state machine is not ready", 0);
+		return;
+	}
+
+	try {
+		/* Start a new parse, if there's none or the previous one is over. */
+		if (!zppo->push || zppo->results->entry.action == parsertl::accept || zppo->results->entry.action == parsertl::error) {
+			if (!zppo->push) {
+				zppo->push = new parle_parser_push{};
+			}
+			zppo->push->buf.clear();
+			zppo->push->buf_offset = 0;
+			zppo->push->productions.clear();
+			zppo->push->need_token = true;
+			if (!zppo->results) {
+				zppo->results = new parsertl::match_results{};
+			}
+			zppo->results->clear();
+		} else if (!zppo->push->need_token) {
+			zend_throw_exception(ParleParserException_ce, "Parser is not waiting for a token", 0);
+			return;
+		}
+
+		php_parle_parser_push_token(zppo, static_cast<size_t>(id), val ? ZSTR_VAL(val) : "", val ? ZSTR_LEN(val) : 0);
+
+		RETURN_LONG(zppo->results->entry.action);
 	} catch (const std::exception &e) {
 		zend_throw_exception(ParleParserException_ce, e.what(), 0);
 	}
@@ -1013,15 +3581,27 @@ PHP_METHOD(ParleParser, consume)
 		if (zppo->productions) {
 			delete zppo->productions;
 		}
-		zppo->productions = new parsertl::token<lexertl::siterator>::token_vector{};
+		if (zppo->push) {
+			delete zppo->push;
+			zppo->push = nullptr;
+		}
+		zppo->productions = new parsertl::token<parle_siterator>::token_vector{};
 		if (zppo->in) {
 			delete zppo->in;
 		}
-		zppo->in = new std::string{ZSTR_VAL(in)};
+		zppo->in = new parle_string{ZSTR_VAL(in)};
+		/* The filter is copied, the lexer may change it while parsing. */
+		if (zppo->filter) {
+			delete zppo->filter;
+			zppo->filter = nullptr;
+		}
+		if (zplo->filter) {
+			zppo->filter = new parle_id_filter(*zplo->filter);
+		}
 		if (zppo->iter) {
 			delete zppo->iter;
 		}
-		zppo->iter = new lexertl::siterator(zppo->in->begin(), zppo->in->end(), *zplo->sm);
+		zppo->iter = new parle_siterator(zppo->in->begin(), zppo->in->end(), *zplo->sm, zppo->filter);
 		if (zppo->results) {
 			delete zppo->results;
 		}
@@ -1058,6 +3638,71 @@ PHP_METHOD(ParleParser, dump)
 }
 /* }}} */
 
+/* {{{ public array Parser::stats(void) */
+PHP_METHOD(ParleParser, stats)
+{
+	struct ze_parle_parser_obj *zppo;
+	zval *me, bytes;
+	size_t rules_bytes, input_bytes = 0, results_bytes = 0;
+
+	if(zend_parse_method_parameters(ZEND_NUM_ARGS(), getThis(), "O", &me, ParleParser_ce) == FAILURE) {
+		return;
+	}
+
+	zppo = php_parle_parser_fetch_obj(Z_OBJ_P(me));
+
+	if (!zppo->complete) {
+		zend_throw_exception(ParleParserException_ce, "Parser state machine is not ready", 0);
+		return;
+	}
+
+	const parsertl::state_machine &sm = *zppo->sm;
+	size_t terminals = zppo->rules->tokens_info().size();
+
+	rules_bytes = php_parle_bytes(sm._rules);
+	for (const auto &rule : sm._rules) {
+		rules_bytes += php_parle_bytes(rule.second);
+	}
+
+	if (zppo->in) {
+		input_bytes += php_parle_bytes(*zppo->in);
+	}
+	if (zppo->results) {
+		results_bytes += sizeof(*zppo->results) + php_parle_bytes(zppo->results->stack);
+	}
+	if (zppo->productions) {
+		results_bytes += php_parle_bytes(*zppo->productions);
+	}
+	if (zppo->iter) {
+		results_bytes += sizeof(*zppo->iter);
+	}
+	if (zppo->push) {
+		input_bytes += php_parle_bytes(zppo->push->buf);
+		results_bytes += php_parle_bytes(zppo->push->productions);
+	}
+	if (zppo->reparse) {
+		input_bytes += php_parle_bytes(zppo->reparse->in);
+		results_bytes += php_parle_bytes(zppo->reparse->snapshots);
+		for (const auto &snap : zppo->reparse->snapshots) {
+			results_bytes += php_parle_bytes(snap.stack);
+		}
+	}
+
+	array_init(return_value);
+	add_assoc_long_ex(return_value, "states", sizeof("states")-1, static_cast<zend_long>(sm._rows));
+	add_assoc_long_ex(return_value, "terminals", sizeof("terminals")-1, static_cast<zend_long>(terminals));
+	add_assoc_long_ex(return_value, "nonTerminals", sizeof("nonTerminals")-1, static_cast<zend_long>(sm._columns - terminals));
+	add_assoc_long_ex(return_value, "productions", sizeof("productions")-1, static_cast<zend_long>(sm._rules.size()));
+
+	array_init(&bytes);
+	add_assoc_long_ex(&bytes, "table", sizeof("table")-1, static_cast<zend_long>(php_parle_bytes(sm._table)));
+	add_assoc_long_ex(&bytes, "rules", sizeof("rules")-1, static_cast<zend_long>(rules_bytes));
+	add_assoc_long_ex(&bytes, "input", sizeof("input")-1, static_cast<zend_long>(input_bytes));
+	add_assoc_long_ex(&bytes, "results", sizeof("results")-1, static_cast<zend_long>(results_bytes));
+	add_assoc_zval_ex(return_value, "bytes", sizeof("bytes")-1, &bytes);
+}
+/* }}} */
+
 /* {{{ public string Parser::trace(void) */
 PHP_METHOD(ParleParser, trace)
 {
@@ -1143,7 +3788,12 @@ PHP_METHOD(ParleParser, errorInfo)
 
 	try {
 		add_property_long_ex(return_value, "id", sizeof("id")-1, static_cast<zend_long>(zppo->results->entry.param));
-		if (zppo->results->entry.param == parsertl::unknown_token) {
+		if (zppo->results->entry.param == parsertl::unknown_token && zppo->push) {
+			zval token;
+			php_parle_token_init(&token, static_cast<zend_long>(zppo->push->token.id), zppo->push->buf.c_str() + zppo->push->token.first,
+				zppo->push->token.second - zppo->push->token.first, zppo->push->buf_offset + zppo->push->token.first);
+			add_property_zval_ex(return_value, "token", sizeof("token")-1, &token);
+		} else if (zppo->results->entry.param == parsertl::unknown_token) {
 			zval token;
 			std::string ret = (*zppo->iter)->str();
 			object_init_ex(&token, ParleToken_ce);
@@ -1153,6 +3803,8 @@ PHP_METHOD(ParleParser, errorInfo)
 			add_property_stringl_ex(&token, "value", sizeof("value")-1, (char *)ret.c_str(), ret.size());
 #endif
 			add_property_long(&token, "offset", (*zppo->iter)->first - zppo->in->begin());
+			struct parle_line_index lines{0, 0, {}, 0};
+			php_parle_token_position(&token, lines, zppo->in->data(), 0, (*zppo->iter)->first - zppo->in->begin());
 			add_property_zval_ex(return_value, "token", sizeof("token")-1, &token);
 		}
 		/* TODO provide details also for other error types, if possible. */
@@ -1299,6 +3951,7 @@ ZEND_END_ARG_INFO();
 #endif
 
 ZEND_BEGIN_ARG_INFO_EX(arginfo_parle_lexer_build, 0, 0, 0)
+	ZEND_ARG_TYPE_INFO(0, lazy_states, IS_LONG, 0)
 ZEND_END_ARG_INFO();
 
 ZEND_BEGIN_ARG_INFO_EX(arginfo_parle_lexer_consume, 0, 0, 1)
@@ -1308,6 +3961,25 @@ ZEND_END_ARG_INFO();
 ZEND_BEGIN_ARG_INFO_EX(arginfo_parle_lexer_advance, 0, 0, 0)
 ZEND_END_ARG_INFO();
 
+ZEND_BEGIN_ARG_INFO_EX(arginfo_parle_lexer_cursor, 0, 0, 1)
+	ZEND_ARG_TYPE_INFO(0, data, IS_STRING, 0)
+ZEND_END_ARG_INFO();
+
+PARLE_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_parle_lexer_tokenizeparallel, 0, 2, IS_ARRAY, 0)
+	ZEND_ARG_TYPE_INFO(0, in, IS_STRING, 0)
+	ZEND_ARG_TYPE_INFO(0, threads, IS_LONG, 0)
+ZEND_END_ARG_INFO();
+
+#if PHP_MAJOR_VERSION >= 7 && PHP_MINOR_VERSION < 2
+PARLE_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_parle_lexer_peek, 0, 0, IS_OBJECT, 0)
+	ZEND_ARG_TYPE_INFO(0, n, IS_LONG, 0)
+ZEND_END_ARG_INFO();
+#elif PHP_MAJOR_VERSION >= 7
+ZEND_BEGIN_ARG_WITH_RETURN_OBJ_INFO(arginfo_parle_lexer_peek, "Parle\\Token", 0)
+	ZEND_ARG_TYPE_INFO(0, n, IS_LONG, 0)
+ZEND_END_ARG_INFO();
+#endif
+
 PARLE_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_parle_lexer_bol, 0, 0, _IS_BOOL, 1)
 	ZEND_ARG_TYPE_INFO(0, bol, _IS_BOOL, 0)
 ZEND_END_ARG_INFO();
@@ -1319,6 +3991,9 @@ ZEND_END_ARG_INFO();
 ZEND_BEGIN_ARG_INFO_EX(arginfo_parle_lexer_dump, 0, 0, 0)
 ZEND_END_ARG_INFO();
 
+PARLE_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_parle_lexer_stats, 0, 0, IS_ARRAY, 0)
+ZEND_END_ARG_INFO();
+
 PARLE_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_parle_lexer_pushstate, 0, 1, IS_LONG, 0)
 	ZEND_ARG_TYPE_INFO(0, state, IS_STRING, 0)
 ZEND_END_ARG_INFO();
@@ -1330,6 +4005,41 @@ PARLE_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_parle_lexer_flags, 0, 0, IS_LON
 	ZEND_ARG_TYPE_INFO(0, state, IS_LONG, 0)
 ZEND_END_ARG_INFO();
 
+ZEND_BEGIN_ARG_INFO_EX(arginfo_parle_lexer_keywords, 0, 0, 2)
+	ZEND_ARG_TYPE_INFO(0, map, IS_ARRAY, 0)
+	ZEND_ARG_TYPE_INFO(0, identifier_id, IS_LONG, 0)
+	ZEND_ARG_TYPE_INFO(0, icase, _IS_BOOL, 0)
+ZEND_END_ARG_INFO();
+
+PARLE_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_parle_lexer_feed, 0, 1, IS_ARRAY, 0)
+	ZEND_ARG_TYPE_INFO(0, chunk, IS_STRING, 0)
+	ZEND_ARG_TYPE_INFO(0, final, _IS_BOOL, 0)
+ZEND_END_ARG_INFO();
+
+PARLE_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_parle_lexer_relex, 0, 3, IS_ARRAY, 0)
+	ZEND_ARG_TYPE_INFO(0, edit_start, IS_LONG, 0)
+	ZEND_ARG_TYPE_INFO(0, old_len, IS_LONG, 0)
+	ZEND_ARG_TYPE_INFO(0, new_text, IS_STRING, 0)
+ZEND_END_ARG_INFO();
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_parle_lexer_setfilter, 0, 0, 1)
+	ZEND_ARG_ARRAY_INFO(0, ids, 0)
+ZEND_END_ARG_INFO();
+
+PARLE_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_parle_lexer_replace, 0, 2, IS_STRING, 0)
+	ZEND_ARG_TYPE_INFO(0, data, IS_STRING, 0)
+	ZEND_ARG_INFO(0, replacements) /* Array of id => string|callable, or a callable. */
+ZEND_END_ARG_INFO();
+
+PARLE_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_parle_lexer_split, 0, 1, IS_ARRAY, 0)
+	ZEND_ARG_TYPE_INFO(0, data, IS_STRING, 0)
+ZEND_END_ARG_INFO();
+
+PARLE_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_parle_lexer_counttokens, 0, 1, IS_ARRAY, 0)
+	ZEND_ARG_TYPE_INFO(0, data, IS_STRING, 0)
+	ZEND_ARG_TYPE_INFO(0, threads, IS_LONG, 0)
+ZEND_END_ARG_INFO();
+
 ZEND_BEGIN_ARG_INFO_EX(arginfo_parle_parser_token, 0, 0, 1)
 	ZEND_ARG_TYPE_INFO(0, tok, IS_STRING, 0)
 ZEND_END_ARG_INFO();
@@ -1351,6 +4061,7 @@ ZEND_BEGIN_ARG_INFO_EX(arginfo_parle_parser_precedence, 0, 0, 1)
 ZEND_END_ARG_INFO();
 
 ZEND_BEGIN_ARG_INFO_EX(arginfo_parle_parser_build, 0, 0, 0)
+	ZEND_ARG_ARRAY_INFO(0, unit_actions, 1)
 ZEND_END_ARG_INFO();
 
 PARLE_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_parle_parser_push, 0, 2, IS_LONG, 0)
@@ -1361,6 +4072,20 @@ ZEND_END_ARG_INFO();
 PARLE_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_parle_parser_validate, 0, 0, _IS_BOOL, 0)
 ZEND_END_ARG_INFO();
 
+PARLE_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_parle_parser_many, 0, 2, IS_ARRAY, 0)
+	ZEND_ARG_ARRAY_INFO(0, inputs, 0)
+	ZEND_ARG_INFO(0, lexer) /* Parle\Lexer or a derivative. */
+	ZEND_ARG_TYPE_INFO(0, threads, IS_LONG, 0)
+ZEND_END_ARG_INFO();
+
+PARLE_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_parle_parser_reparse, 0, 4, _IS_BOOL, 0)
+	ZEND_ARG_TYPE_INFO(0, edit_start, IS_LONG, 0)
+	ZEND_ARG_TYPE_INFO(0, old_len, IS_LONG, 0)
+	ZEND_ARG_TYPE_INFO(0, new_text, IS_STRING, 0)
+	ZEND_ARG_INFO(0, lexer) /* Parle\Lexer or a derivative. */
+	ZEND_ARG_INFO(1, reductions)
+ZEND_END_ARG_INFO();
+
 PARLE_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_parle_parser_tokenid, 0, 1, IS_LONG, 0)
 	ZEND_ARG_TYPE_INFO(0, tok, IS_STRING, 0)
 ZEND_END_ARG_INFO();
@@ -1378,14 +4103,26 @@ ZEND_END_ARG_INFO();
 ZEND_BEGIN_ARG_INFO_EX(arginfo_parle_parser_advance, 0, 0, 0)
 ZEND_END_ARG_INFO();
 
+PARLE_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_parle_parser_advanceuntil, 0, 1, IS_LONG, 0)
+	ZEND_ARG_ARRAY_INFO(0, reduce_ids, 0)
+ZEND_END_ARG_INFO();
+
 ZEND_BEGIN_ARG_INFO_EX(arginfo_parle_parser_consume, 0, 0, 2)
 	ZEND_ARG_TYPE_INFO(0, data, IS_STRING, 0)
 	ZEND_ARG_INFO(0, lexer) /* Parle\Lexer or a derivative. */
 ZEND_END_ARG_INFO();
 
+PARLE_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_parle_parser_pushtoken, 0, 1, IS_LONG, 0)
+	ZEND_ARG_TYPE_INFO(0, id, IS_LONG, 0)
+	ZEND_ARG_TYPE_INFO(0, value, IS_STRING, 1)
+ZEND_END_ARG_INFO();
+
 ZEND_BEGIN_ARG_INFO_EX(arginfo_parle_parser_dump, 0, 0, 0)
 ZEND_END_ARG_INFO();
 
+PARLE_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_parle_parser_stats, 0, 0, IS_ARRAY, 0)
+ZEND_END_ARG_INFO();
+
 PARLE_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_parle_parser_trace, 0, 0, IS_STRING, 0)
 ZEND_END_ARG_INFO();
 
@@ -1436,12 +4173,23 @@ const zend_function_entry ParleLexer_methods[] = {
 	PHP_ME(ParleLexer, getToken, arginfo_parle_lexer_gettoken, ZEND_ACC_PUBLIC)
 	PHP_ME(ParleLexer, build, arginfo_parle_lexer_build, ZEND_ACC_PUBLIC)
 	PHP_ME(ParleLexer, consume, arginfo_parle_lexer_consume, ZEND_ACC_PUBLIC)
+	PHP_ME(ParleLexer, feed, arginfo_parle_lexer_feed, ZEND_ACC_PUBLIC)
+	PHP_ME(ParleLexer, relex, arginfo_parle_lexer_relex, ZEND_ACC_PUBLIC)
 	PHP_ME(ParleLexer, advance, arginfo_parle_lexer_advance, ZEND_ACC_PUBLIC)
+	PHP_ME(ParleLexer, peek, arginfo_parle_lexer_peek, ZEND_ACC_PUBLIC)
+	PHP_ME(ParleLexer, tokenizeParallel, arginfo_parle_lexer_tokenizeparallel, ZEND_ACC_PUBLIC)
+	PHP_ME(ParleLexer, cursor, arginfo_parle_lexer_cursor, ZEND_ACC_PUBLIC)
 	PHP_ME(ParleLexer, bol, arginfo_parle_lexer_bol, ZEND_ACC_PUBLIC)
 	PHP_ME(ParleLexer, restart, arginfo_parle_lexer_restart, ZEND_ACC_PUBLIC)
 	PHP_ME(ParleLexer, insertMacro, NULL, ZEND_ACC_PUBLIC)
+	PHP_ME(ParleLexer, keywords, arginfo_parle_lexer_keywords, ZEND_ACC_PUBLIC)
 	PHP_ME(ParleLexer, dump, arginfo_parle_lexer_dump, ZEND_ACC_PUBLIC)
+	PHP_ME(ParleLexer, stats, arginfo_parle_lexer_stats, ZEND_ACC_PUBLIC)
 	PHP_ME(ParleLexer, flags, arginfo_parle_lexer_flags, ZEND_ACC_PUBLIC)
+	PHP_ME(ParleLexer, setFilter, arginfo_parle_lexer_setfilter, ZEND_ACC_PUBLIC)
+	PHP_ME(ParleLexer, replace, arginfo_parle_lexer_replace, ZEND_ACC_PUBLIC)
+	PHP_ME(ParleLexer, split, arginfo_parle_lexer_split, ZEND_ACC_PUBLIC)
+	PHP_ME(ParleLexer, countTokens, arginfo_parle_lexer_counttokens, ZEND_ACC_PUBLIC)
 	PHP_FE_END
 };
 
@@ -1450,14 +4198,42 @@ const zend_function_entry ParleRLexer_methods[] = {
 	PHP_ME(ParleRLexer, getToken, arginfo_parle_lexer_gettoken, ZEND_ACC_PUBLIC)
 	PHP_ME(ParleRLexer, build, arginfo_parle_lexer_build, ZEND_ACC_PUBLIC)
 	PHP_ME(ParleRLexer, consume, arginfo_parle_lexer_consume, ZEND_ACC_PUBLIC)
+	PHP_ME(ParleRLexer, feed, arginfo_parle_lexer_feed, ZEND_ACC_PUBLIC)
+	PHP_ME(ParleRLexer, relex, arginfo_parle_lexer_relex, ZEND_ACC_PUBLIC)
 	PHP_ME(ParleRLexer, advance, arginfo_parle_lexer_advance, ZEND_ACC_PUBLIC)
+	PHP_ME(ParleRLexer, peek, arginfo_parle_lexer_peek, ZEND_ACC_PUBLIC)
+	PHP_ME(ParleRLexer, cursor, arginfo_parle_lexer_cursor, ZEND_ACC_PUBLIC)
 	PHP_ME(ParleRLexer, bol, arginfo_parle_lexer_bol, ZEND_ACC_PUBLIC)
 	PHP_ME(ParleRLexer, restart, arginfo_parle_lexer_restart, ZEND_ACC_PUBLIC)
 	PHP_ME(ParleRLexer, pushState, arginfo_parle_lexer_pushstate, ZEND_ACC_PUBLIC)
 	PHP_ME(ParleRLexer, state, arginfo_parle_lexer_state, ZEND_ACC_PUBLIC)
 	PHP_ME(ParleRLexer, insertMacro, NULL, ZEND_ACC_PUBLIC)
+	PHP_ME(ParleRLexer, keywords, arginfo_parle_lexer_keywords, ZEND_ACC_PUBLIC)
 	PHP_ME(ParleRLexer, dump, arginfo_parle_lexer_dump, ZEND_ACC_PUBLIC)
+	PHP_ME(ParleRLexer, stats, arginfo_parle_lexer_stats, ZEND_ACC_PUBLIC)
 	PHP_ME(ParleRLexer, flags, arginfo_parle_lexer_flags, ZEND_ACC_PUBLIC)
+	PHP_ME(ParleRLexer, setFilter, arginfo_parle_lexer_setfilter, ZEND_ACC_PUBLIC)
+	PHP_ME(ParleRLexer, replace, arginfo_parle_lexer_replace, ZEND_ACC_PUBLIC)
+	PHP_ME(ParleRLexer, split, arginfo_parle_lexer_split, ZEND_ACC_PUBLIC)
+	PHP_ME(ParleRLexer, countTokens, arginfo_parle_lexer_counttokens, ZEND_ACC_PUBLIC)
+	PHP_FE_END
+};
+
+const zend_function_entry ParleLexerCursor_methods[] = {
+	PHP_ME(ParleLexerCursor, advance, arginfo_parle_lexer_advance, ZEND_ACC_PUBLIC)
+	PHP_ME(ParleLexerCursor, getToken, arginfo_parle_lexer_gettoken, ZEND_ACC_PUBLIC)
+	PHP_ME(ParleLexerCursor, peek, arginfo_parle_lexer_peek, ZEND_ACC_PUBLIC)
+	PHP_ME(ParleLexerCursor, bol, arginfo_parle_lexer_bol, ZEND_ACC_PUBLIC)
+	PHP_ME(ParleLexerCursor, restart, arginfo_parle_lexer_restart, ZEND_ACC_PUBLIC)
+	PHP_FE_END
+};
+
+const zend_function_entry ParleRLexerCursor_methods[] = {
+	PHP_ME(ParleRLexerCursor, advance, arginfo_parle_lexer_advance, ZEND_ACC_PUBLIC)
+	PHP_ME(ParleRLexerCursor, getToken, arginfo_parle_lexer_gettoken, ZEND_ACC_PUBLIC)
+	PHP_ME(ParleRLexerCursor, peek, arginfo_parle_lexer_peek, ZEND_ACC_PUBLIC)
+	PHP_ME(ParleRLexerCursor, bol, arginfo_parle_lexer_bol, ZEND_ACC_PUBLIC)
+	PHP_ME(ParleRLexerCursor, restart, arginfo_parle_lexer_restart, ZEND_ACC_PUBLIC)
 	PHP_FE_END
 };
 
@@ -1470,13 +4246,19 @@ const zend_function_entry ParleParser_methods[] = {
 	PHP_ME(ParleParser, build, arginfo_parle_parser_build, ZEND_ACC_PUBLIC)
 	PHP_ME(ParleParser, push, arginfo_parle_parser_push, ZEND_ACC_PUBLIC)
 	PHP_ME(ParleParser, validate, arginfo_parle_parser_validate, ZEND_ACC_PUBLIC)
+	PHP_ME(ParleParser, reparse, arginfo_parle_parser_reparse, ZEND_ACC_PUBLIC)
+	PHP_ME(ParleParser, validateMany, arginfo_parle_parser_many, ZEND_ACC_PUBLIC)
+	PHP_ME(ParleParser, parseMany, arginfo_parle_parser_many, ZEND_ACC_PUBLIC)
 	PHP_ME(ParleParser, tokenId, arginfo_parle_parser_tokenid, ZEND_ACC_PUBLIC)
 	PHP_ME(ParleParser, reduceId, arginfo_parle_parser_reduceid, ZEND_ACC_PUBLIC)
 	PHP_ME(ParleParser, action, arginfo_parle_parser_action, ZEND_ACC_PUBLIC)
 	PHP_ME(ParleParser, sigil, arginfo_parle_parser_sigil, ZEND_ACC_PUBLIC)
 	PHP_ME(ParleParser, advance, arginfo_parle_parser_advance, ZEND_ACC_PUBLIC)
+	PHP_ME(ParleParser, advanceUntil, arginfo_parle_parser_advanceuntil, ZEND_ACC_PUBLIC)
 	PHP_ME(ParleParser, consume, arginfo_parle_parser_consume, ZEND_ACC_PUBLIC)
+	PHP_ME(ParleParser, pushToken, arginfo_parle_parser_pushtoken, ZEND_ACC_PUBLIC)
 	PHP_ME(ParleParser, dump, arginfo_parle_parser_dump, ZEND_ACC_PUBLIC)
+	PHP_ME(ParleParser, stats, arginfo_parle_parser_stats, ZEND_ACC_PUBLIC)
 	PHP_ME(ParleParser, trace, arginfo_parle_parser_trace, ZEND_ACC_PUBLIC)
 	PHP_ME(ParleParser, errorInfo, arginfo_parle_parser_errorinfo, ZEND_ACC_PUBLIC)
 	PHP_FE_END
@@ -1498,31 +4280,113 @@ php_parle_lexer_obj_dtor(lexer_type *zplo) noexcept
 {/*{{{*/
 	zend_object_std_dtor(&zplo->zo);
 
-	delete zplo->rules;
-	delete zplo->sm;
+	php_parle_shared_release(zplo->rules);
+	php_parle_shared_release(zplo->sm);
 	delete zplo->results;
 	delete zplo->in;
+	delete zplo->filter;
+	delete zplo->in_state;
+	delete zplo->checkpoints;
+	delete zplo->lookahead;
+	delete zplo->lines;
 }/*}}}*/
 
+/* A clone gets its rules and state machine from the original, so they're
+	only made with grammar set. */
 template<typename lexer_type> zend_object *
-php_parle_lexer_obj_ctor(zend_class_entry *ce) noexcept
+php_parle_lexer_obj_ctor(zend_class_entry *ce, zend_object_handlers *handlers, bool grammar) noexcept
 {/*{{{*/
 	lexer_type *zplo;
 
 	zplo = (lexer_type *)ecalloc(1, sizeof(lexer_type));
 
 	zend_object_std_init(&zplo->zo, ce);
-	zplo->zo.handlers = &parle_lexer_handlers;
+	zplo->zo.handlers = handlers;
 
 	zplo->complete = false;
-	zplo->rules = new lexertl::rules{};
-	zplo->sm = new lexertl::state_machine{};
+	zplo->rules = grammar ? new parle_lexer_rules{} : nullptr;
+	zplo->sm = grammar ? new parle_lexer_sm{} : nullptr;
 	zplo->results = nullptr;
 	zplo->in = nullptr;
+	zplo->in_offset = 0;
+	zplo->in_state = nullptr;
+	zplo->checkpoints = nullptr;
+	zplo->lookahead = nullptr;
+	zplo->lines = nullptr;
+	zplo->filter = nullptr;
 
 	return &zplo->zo;
 }/*}}}*/
 
+/* Move match results over from one copy of the input to another. */
+template<typename lexer_type> static void
+php_parle_lexer_rebase(lexer_type &results, const parle_string &from, const parle_string &to) noexcept
+{/*{{{*/
+	results.first = to.begin() + (results.first - from.begin());
+	results.second = to.begin() + (results.second - from.begin());
+	results.eoi = to.begin() + (results.eoi - from.begin());
+}/*}}}*/
+
+/* Copy the per input state of a lexer or cursor. The relex() checkpoints
+	aren't copied, they're collected again when needed. */
+template<typename obj_type, typename lexer_type> static void
+php_parle_lexer_copy_input(obj_type *dst, const obj_type *src)
+{/*{{{*/
+	if (src->filter) {
+		dst->filter = new parle_id_filter(*src->filter);
+	}
+	if (!src->in) {
+		return;
+	}
+
+	dst->in = new parle_string(*src->in);
+	dst->in_offset = src->in_offset;
+	if (src->results) {
+		dst->results = new lexer_type(*src->results);
+		php_parle_lexer_rebase(*dst->results, *src->in, *dst->in);
+	}
+	if (src->lookahead) {
+		dst->lookahead = new parle_deque<lexer_type>(*src->lookahead);
+		for (auto &la : *dst->lookahead) {
+			php_parle_lexer_rebase(la, *src->in, *dst->in);
+		}
+	}
+	if (src->lines) {
+		dst->lines = new parle_line_index(*src->lines);
+	}
+}/*}}}*/
+
+/* A built lexer shares its rules and state machine with the clone, only
+	the input is copied. An unfinished one gets its rules copied. */
+template<typename lexer_obj_type, typename lexer_type> zend_object *
+php_parle_lexer_obj_clone(zval *zv, zend_object_handlers *handlers) noexcept
+{/*{{{*/
+	lexer_obj_type *src = _php_parle_lexer_fetch_zobj<lexer_obj_type>(Z_OBJ_P(zv));
+	zend_object *zo = php_parle_lexer_obj_ctor<lexer_obj_type>(src->zo.ce, handlers, false);
+	lexer_obj_type *dst = _php_parle_lexer_fetch_zobj<lexer_obj_type>(zo);
+
+	zend_objects_clone_members(zo, &src->zo);
+
+	try {
+		if (src->complete) {
+			dst->rules = php_parle_shared_addref(src->rules);
+			dst->sm = php_parle_shared_addref(src->sm);
+		} else {
+			dst->rules = new parle_lexer_rules(static_cast<const lexertl::rules &>(*src->rules));
+			dst->sm = new parle_lexer_sm{};
+		}
+		dst->complete = src->complete;
+		php_parle_lexer_copy_input<lexer_obj_type, lexer_type>(dst, src);
+		if (src->in_state) {
+			dst->in_state = new lexer_type(*src->in_state);
+		}
+	} catch (const std::exception &e) {
+		zend_throw_exception(ParleLexerException_ce, e.what(), 0);
+	}
+
+	return zo;
+}/*}}}*/
+
 void
 php_parle_lexer_obj_destroy(zend_object *obj) noexcept
 {/*{{{*/
@@ -1533,7 +4397,13 @@ php_parle_lexer_obj_destroy(zend_object *obj) noexcept
 zend_object *
 php_parle_lexer_object_init(zend_class_entry *ce) noexcept
 {/*{{{*/
-	return php_parle_lexer_obj_ctor<struct ze_parle_lexer_obj>(ce);
+	return php_parle_lexer_obj_ctor<struct ze_parle_lexer_obj>(ce, &parle_lexer_handlers, true);
+}/*}}}*/
+
+zend_object *
+php_parle_lexer_object_clone(zval *zv) noexcept
+{/*{{{*/
+	return php_parle_lexer_obj_clone<struct ze_parle_lexer_obj, parle_smatch>(zv, &parle_lexer_handlers);
 }/*}}}*/
 
 void
@@ -1546,7 +4416,107 @@ php_parle_rlexer_obj_destroy(zend_object *obj) noexcept
 zend_object *
 php_parle_rlexer_object_init(zend_class_entry *ce) noexcept
 {/*{{{*/
-	return php_parle_lexer_obj_ctor<struct ze_parle_rlexer_obj>(ce);
+	return php_parle_lexer_obj_ctor<struct ze_parle_rlexer_obj>(ce, &parle_rlexer_handlers, true);
+}/*}}}*/
+
+zend_object *
+php_parle_rlexer_object_clone(zval *zv) noexcept
+{/*{{{*/
+	return php_parle_lexer_obj_clone<struct ze_parle_rlexer_obj, parle_srmatch>(zv, &parle_rlexer_handlers);
+}/*}}}*/
+
+template<typename cursor_type> void
+php_parle_lexer_cursor_obj_dtor(cursor_type *zpco) noexcept
+{/*{{{*/
+	zend_object_std_dtor(&zpco->zo);
+
+	php_parle_shared_release(zpco->sm);
+	delete zpco->results;
+	delete zpco->in;
+	delete zpco->filter;
+	delete zpco->lookahead;
+	delete zpco->lines;
+}/*}}}*/
+
+template<typename cursor_type> zend_object *
+php_parle_lexer_cursor_obj_ctor(zend_class_entry *ce, zend_object_handlers *handlers) noexcept
+{/*{{{*/
+	cursor_type *zpco;
+
+	zpco = (cursor_type *)ecalloc(1, sizeof(cursor_type));
+
+	zend_object_std_init(&zpco->zo, ce);
+	zpco->zo.handlers = handlers;
+
+	/* Filled in by Lexer::cursor(), one made otherwise isn't usable. */
+	zpco->complete = false;
+	zpco->sm = nullptr;
+	zpco->results = nullptr;
+	zpco->in = nullptr;
+	zpco->in_offset = 0;
+	zpco->filter = nullptr;
+	zpco->lookahead = nullptr;
+	zpco->lines = nullptr;
+
+	return &zpco->zo;
+}/*}}}*/
+
+template<typename cursor_type, typename lexer_type> zend_object *
+php_parle_lexer_cursor_obj_clone(zval *zv, zend_object_handlers *handlers) noexcept
+{/*{{{*/
+	cursor_type *src = _php_parle_lexer_fetch_zobj<cursor_type>(Z_OBJ_P(zv));
+	zend_object *zo = php_parle_lexer_cursor_obj_ctor<cursor_type>(src->zo.ce, handlers);
+	cursor_type *dst = _php_parle_lexer_fetch_zobj<cursor_type>(zo);
+
+	zend_objects_clone_members(zo, &src->zo);
+
+	try {
+		if (src->sm) {
+			dst->sm = php_parle_shared_addref(src->sm);
+		}
+		dst->complete = src->complete;
+		php_parle_lexer_copy_input<cursor_type, lexer_type>(dst, src);
+	} catch (const std::exception &e) {
+		zend_throw_exception(ParleLexerException_ce, e.what(), 0);
+	}
+
+	return zo;
+}/*}}}*/
+
+void
+php_parle_lexer_cursor_obj_destroy(zend_object *obj) noexcept
+{/*{{{*/
+	php_parle_lexer_cursor_obj_dtor(_php_parle_lexer_fetch_zobj<struct ze_parle_lexer_cursor_obj>(obj));
+}/*}}}*/
+
+zend_object *
+php_parle_lexer_cursor_object_init(zend_class_entry *ce) noexcept
+{/*{{{*/
+	return php_parle_lexer_cursor_obj_ctor<struct ze_parle_lexer_cursor_obj>(ce, &parle_lexer_cursor_handlers);
+}/*}}}*/
+
+zend_object *
+php_parle_lexer_cursor_object_clone(zval *zv) noexcept
+{/*{{{*/
+	return php_parle_lexer_cursor_obj_clone<struct ze_parle_lexer_cursor_obj, parle_smatch>(zv, &parle_lexer_cursor_handlers);
+}/*}}}*/
+
+void
+php_parle_rlexer_cursor_obj_destroy(zend_object *obj) noexcept
+{/*{{{*/
+	php_parle_lexer_cursor_obj_dtor(_php_parle_lexer_fetch_zobj<struct ze_parle_rlexer_cursor_obj>(obj));
+}/*}}}*/
+
+zend_object *
+php_parle_rlexer_cursor_object_init(zend_class_entry *ce) noexcept
+{/*{{{*/
+	return php_parle_lexer_cursor_obj_ctor<struct ze_parle_rlexer_cursor_obj>(ce, &parle_rlexer_cursor_handlers);
+}/*}}}*/
+
+zend_object *
+php_parle_rlexer_cursor_object_clone(zval *zv) noexcept
+{/*{{{*/
+	return php_parle_lexer_cursor_obj_clone<struct ze_parle_rlexer_cursor_obj, parle_srmatch>(zv, &parle_rlexer_cursor_handlers);
 }/*}}}*/
 
 void
@@ -1556,16 +4526,20 @@ php_parle_parser_obj_destroy(zend_object *obj) noexcept
 
 	zend_object_std_dtor(&zppo->zo);
 
-	delete zppo->rules;
-	delete zppo->sm;
+	php_parle_shared_release(zppo->rules);
+	php_parle_shared_release(zppo->sm);
 	delete zppo->results;
 	delete zppo->in;
 	delete zppo->iter;
 	delete zppo->productions;
+	delete zppo->filter;
+	delete zppo->push;
+	delete zppo->reparse;
 }/*}}}*/
 
-zend_object *
-php_parle_parser_object_init(zend_class_entry *ce) noexcept
+/* Like with the lexer, the grammar of a clone comes from the original. */
+static zend_object *
+php_parle_parser_obj_ctor(zend_class_entry *ce, bool grammar) noexcept
 {/*{{{*/
 	struct ze_parle_parser_obj *zppo;
 
@@ -1575,16 +4549,72 @@ php_parle_parser_object_init(zend_class_entry *ce) noexcept
 	zppo->zo.handlers = &parle_parser_handlers;
 
 	zppo->complete = false;
-	zppo->rules = new parsertl::rules{};
-	zppo->sm = new parsertl::state_machine{};
+	zppo->rules = grammar ? new parle_parser_rules{} : nullptr;
+	zppo->sm = grammar ? new parle_parser_sm{} : nullptr;
 	zppo->results = nullptr;
 	zppo->in = nullptr;
 	zppo->iter = nullptr;
 	zppo->productions = nullptr;
+	zppo->filter = nullptr;
+	zppo->push = nullptr;
+	zppo->reparse = nullptr;
 
 	return &zppo->zo;
 }/*}}}*/
 
+zend_object *
+php_parle_parser_object_init(zend_class_entry *ce) noexcept
+{/*{{{*/
+	return php_parle_parser_obj_ctor(ce, true);
+}/*}}}*/
+
+/* The clone shares a built grammar. A parse in push mode and the document
+	kept by reparse() are copied, a pull mode parse isn't, as the lexer
+	iterator can't be moved over to a copy of the input. */
+zend_object *
+php_parle_parser_object_clone(zval *zv) noexcept
+{/*{{{*/
+	struct ze_parle_parser_obj *src = php_parle_parser_fetch_obj(Z_OBJ_P(zv));
+	zend_object *zo = php_parle_parser_obj_ctor(src->zo.ce, false);
+	struct ze_parle_parser_obj *dst = php_parle_parser_fetch_obj(zo);
+
+	zend_objects_clone_members(zo, &src->zo);
+
+	try {
+		if (src->complete) {
+			dst->rules = php_parle_shared_addref(src->rules);
+			dst->sm = php_parle_shared_addref(src->sm);
+		} else {
+			dst->rules = new parle_parser_rules(static_cast<const parsertl::rules &>(*src->rules));
+			dst->sm = new parle_parser_sm{};
+		}
+		dst->complete = src->complete;
+
+		if (src->push) {
+			dst->push = new parle_parser_push(*src->push);
+			dst->results = new parsertl::match_results(*src->results);
+		}
+		if (src->reparse) {
+			const struct parle_parser_reparse &rp = *src->reparse;
+
+			dst->reparse = new parle_parser_reparse{rp.in, rp.snapshots, nullptr, nullptr, rp.valid};
+			if (rp.lex_sm) {
+				dst->reparse->lex_sm = php_parle_shared_addref(rp.lex_sm);
+			}
+			if (rp.filter) {
+				dst->reparse->filter = new parle_id_filter(*rp.filter);
+			}
+			for (auto &snap : dst->reparse->snapshots) {
+				php_parle_lexer_rebase(snap.lex.results, rp.in, dst->reparse->in);
+			}
+		}
+	} catch (const std::exception &e) {
+		zend_throw_exception(ParleParserException_ce, e.what(), 0);
+	}
+
+	return zo;
+}/*}}}*/
+
 void
 php_parle_parser_stack_obj_destroy(zend_object *obj) noexcept
 {/*{{{*/
@@ -1621,12 +4651,12 @@ php_parle_parser_stack_object_init(zend_class_entry *ce) noexcept
 
 /* {{{ PHP_INI
  */
-/* Remove comments and fill if you need to have entries in php.ini
 PHP_INI_BEGIN()
-    STD_PHP_INI_ENTRY("parle.global_value",      "42", PHP_INI_ALL, OnUpdateLong, global_value, zend_parle_globals, parle_globals)
-    STD_PHP_INI_ENTRY("parle.global_string", "foobar", PHP_INI_ALL, OnUpdateString, global_string, zend_parle_globals, parle_globals)
+	/* Size of the thread pool for the batch methods, 0 for one per CPU. */
+	PHP_INI_ENTRY("parle.threads", "0", PHP_INI_SYSTEM, NULL)
+	/* Rows a lexer state's DFA may have before it is built lazily, 0 for no limit. */
+	PHP_INI_ENTRY("parle.lexer_max_states", "0", PHP_INI_ALL, NULL)
 PHP_INI_END()
-*/
 /* }}} */
 
 /* {{{ php_parle_init_globals
@@ -1646,9 +4676,7 @@ PHP_MINIT_FUNCTION(parle)
 {
 	zend_class_entry ce;
 
-	/* If you have INI entries, uncomment these lines
 	REGISTER_INI_ENTRIES();
-	*/
 
 	INIT_CLASS_ENTRY(ce, "Parle\\ErrorInfo", ParleErrorInfo_methods);
 	ParleErrorInfo_ce = zend_register_internal_class(&ce);
@@ -1665,9 +4693,11 @@ PHP_MINIT_FUNCTION(parle)
 	zend_declare_property_long(ParleToken_ce, "id", sizeof("id")-1, static_cast<zend_long>(lexertl::smatch::npos()), ZEND_ACC_PUBLIC);
 	zend_declare_property_null(ParleToken_ce, "value", sizeof("value")-1, ZEND_ACC_PUBLIC);
 	zend_declare_property_long(ParleToken_ce, "offset", sizeof("offset")-1, Z_L(-1), ZEND_ACC_PUBLIC);
+	zend_declare_property_long(ParleToken_ce, "line", sizeof("line")-1, Z_L(-1), ZEND_ACC_PUBLIC);
+	zend_declare_property_long(ParleToken_ce, "column", sizeof("column")-1, Z_L(-1), ZEND_ACC_PUBLIC);
 
 	memcpy(&parle_lexer_handlers, zend_get_std_object_handlers(), sizeof(zend_object_handlers));
-	parle_lexer_handlers.clone_obj = NULL;
+	parle_lexer_handlers.clone_obj = php_parle_lexer_object_clone;
 	parle_lexer_handlers.offset = XtOffsetOf(struct ze_parle_lexer_obj, zo);
 	parle_lexer_handlers.free_obj = php_parle_lexer_obj_destroy;
 
@@ -1683,7 +4713,7 @@ PHP_MINIT_FUNCTION(parle)
 #undef DECL_CONST
 
 	memcpy(&parle_rlexer_handlers, zend_get_std_object_handlers(), sizeof(zend_object_handlers));
-	parle_rlexer_handlers.clone_obj = NULL;
+	parle_rlexer_handlers.clone_obj = php_parle_rlexer_object_clone;
 	parle_rlexer_handlers.offset = XtOffsetOf(struct ze_parle_rlexer_obj, zo);
 	parle_rlexer_handlers.free_obj = php_parle_rlexer_obj_destroy;
 
@@ -1691,8 +4721,26 @@ PHP_MINIT_FUNCTION(parle)
 	ce.create_object = php_parle_rlexer_object_init;
 	ParleRLexer_ce = zend_register_internal_class_ex(&ce, ParleLexer_ce);
 
+	memcpy(&parle_lexer_cursor_handlers, zend_get_std_object_handlers(), sizeof(zend_object_handlers));
+	parle_lexer_cursor_handlers.clone_obj = php_parle_lexer_cursor_object_clone;
+	parle_lexer_cursor_handlers.offset = XtOffsetOf(struct ze_parle_lexer_cursor_obj, zo);
+	parle_lexer_cursor_handlers.free_obj = php_parle_lexer_cursor_obj_destroy;
+
+	INIT_CLASS_ENTRY(ce, "Parle\\LexerCursor", ParleLexerCursor_methods);
+	ce.create_object = php_parle_lexer_cursor_object_init;
+	ParleLexerCursor_ce = zend_register_internal_class(&ce);
+
+	memcpy(&parle_rlexer_cursor_handlers, zend_get_std_object_handlers(), sizeof(zend_object_handlers));
+	parle_rlexer_cursor_handlers.clone_obj = php_parle_rlexer_cursor_object_clone;
+	parle_rlexer_cursor_handlers.offset = XtOffsetOf(struct ze_parle_rlexer_cursor_obj, zo);
+	parle_rlexer_cursor_handlers.free_obj = php_parle_rlexer_cursor_obj_destroy;
+
+	INIT_CLASS_ENTRY(ce, "Parle\\RLexerCursor", ParleRLexerCursor_methods);
+	ce.create_object = php_parle_rlexer_cursor_object_init;
+	ParleRLexerCursor_ce = zend_register_internal_class(&ce);
+
 	memcpy(&parle_parser_handlers, zend_get_std_object_handlers(), sizeof(zend_object_handlers));
-	parle_parser_handlers.clone_obj = NULL;
+	parle_parser_handlers.clone_obj = php_parle_parser_object_clone;
 	parle_parser_handlers.offset = XtOffsetOf(struct ze_parle_parser_obj, zo);
 	parle_parser_handlers.free_obj = php_parle_parser_obj_destroy;
 
@@ -1732,9 +4780,13 @@ PHP_MINIT_FUNCTION(parle)
  */
 PHP_MSHUTDOWN_FUNCTION(parle)
 {
-	/* uncomment this line if you have INI entries
 	UNREGISTER_INI_ENTRIES();
-	*/
+
+	if (php_parle_thread_pool_owned()) {
+		delete parle_pool;
+	}
+	parle_pool = nullptr;
+
 	return SUCCESS;
 }
 /* }}} */
@@ -1748,9 +4800,7 @@ PHP_MINFO_FUNCTION(parle)
 	php_info_print_table_row(2, "Parle version", PHP_PARLE_VERSION);
 	php_info_print_table_end();
 
-	/* Remove comments if you have entries in php.ini
 	DISPLAY_INI_ENTRIES();
-	*/
 }
 /* }}} */
 
@@ -0,0 +1,115 @@
+--TEST--
+Calc with tokens pushed into the parser
+--SKIPIF--
+<?php if (!extension_loaded("parle")) print "skip"; ?>
+--FILE--
+<?php 
+
+use Parle\Parser;
+use Parle\ParserException;
+use Parle\Stack;
+
+$p = new Parser;
+$p->token("INTEGER");
+$p->left("'+' '-'");
+$p->left("'*' '/'");
+
+$p->push("start", "exp");
+$add_idx = $p->push("exp", "exp '+' exp");
+$sub_idx = $p->push("exp", "exp '-' exp");
+$mul_idx = $p->push("exp", "exp '*' exp");
+$div_idx = $p->push("exp", "exp '/' exp");
+$p->push("exp", "'(' exp ')'");
+$int_idx = $p->push("exp", "INTEGER");
+
+$p->build();
+
+$exp = array(
+	"2 + 3 * (4 + 1)",
+	"100 / 5 - 3",
+	"2 + * 3",
+);
+
+foreach ($exp as $in) {
+	/* Tokens are produced outside of parle and pushed one by one. */
+	preg_match_all("/\\d+|[-+*\\/()]/", $in, $m);
+	$toks = $m[0];
+	$toks[] = "";
+
+	$stack = new Stack;
+	foreach ($toks as $tok) {
+		if ("" === $tok) {
+			$id = 0;
+		} else if (ctype_digit($tok)) {
+			$id = $p->tokenId("INTEGER");
+		} else {
+			$id = $p->tokenId("'$tok'");
+		}
+
+		$act = $p->pushToken($id, $tok);
+		while (Parser::ACTION_REDUCE == $act) {
+			switch ($p->reduceId()) {
+				case $add_idx:
+					$op = $stack->top();
+					$stack->pop();
+					$stack->top($stack->top() + $op);
+					break;
+				case $sub_idx:
+					$op = $stack->top();
+					$stack->pop();
+					$stack->top($stack->top() - $op);
+					break;
+				case $mul_idx:
+					$op = $stack->top();
+					$stack->pop();
+					$stack->top($stack->top() * $op);
+					break;
+				case $div_idx:
+					$op = $stack->top();
+					$stack->pop();
+					$stack->top($stack->top() / $op);
+					break;
+				case $int_idx:
+					$stack->push((int)$p->sigil());
+					break;
+			}
+			$p->advance();
+			$act = $p->action();
+		}
+
+		if (Parser::ACTION_ERROR == $act) {
+			echo "$in: error at '", $tok, "'\n";
+			continue 2;
+		}
+	}
+
+	if (Parser::ACTION_ACCEPT != $act) {
+		throw new ParserException("Input not accepted");
+	}
+	echo "$in = ", $stack->top(), "\n";
+}
+
+/* Ids past the terminals are non-terminals, "exp" here. */
+var_dump(Parser::ACTION_ERROR == $p->pushToken(9, "exp"));
+var_dump(Parser::ACTION_ERROR == $p->pushToken(1000, "x"));
+
+try {
+	$p->pushToken($p->tokenId("INTEGER"), "1");
+	/* Reduces "1" to exp and waits for the action to be handled. */
+	var_dump(Parser::ACTION_REDUCE == $p->pushToken($p->tokenId("'+'"), "+"));
+	$p->pushToken($p->tokenId("INTEGER"), "2");
+} catch (ParserException $e) {
+	echo $e->getMessage(), "\n";
+}
+
+?>
+==DONE==
+--EXPECT--
+2 + 3 * (4 + 1) = 17
+100 / 5 - 3 = 17
+2 + * 3: error at '*'
+bool(true)
+bool(true)
+bool(true)
+Parser is not waiting for a token
+==DONE==
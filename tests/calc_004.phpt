@@ -0,0 +1,123 @@
+--TEST--
+Reparse an edited document
+--SKIPIF--
+<?php if (!extension_loaded("parle")) print "skip"; ?>
+--FILE--
+<?php 
+
+use Parle\Parser;
+use Parle\ParserException;
+use Parle\Lexer;
+use Parle\Token;
+
+$p = new Parser;
+$p->token("INTEGER");
+$p->left("'+' '-'");
+$p->push("start", "list");
+$p->push("list", "%empty | list stmt");
+$p->push("stmt", "exp ';'");
+$p->push("exp", "exp '+' exp | exp '-' exp | '(' exp ')' | INTEGER");
+$p->build();
+
+$lex = new Lexer;
+$lex->push("[+]", $p->tokenId("'+'"));
+$lex->push("[-]", $p->tokenId("'-'"));
+$lex->push("[(]", $p->tokenId("'('"));
+$lex->push("[)]", $p->tokenId("')'"));
+$lex->push(";", $p->tokenId("';'"));
+$lex->push("\\d+", $p->tokenId("INTEGER"));
+$lex->push("\\s+", Token::SKIP);
+$lex->build();
+
+$doc = str_repeat("(1 + 2) - 3;\n", 1000);
+
+/* The document is empty before the first call. */
+var_dump($p->reparse(0, 0, $doc, $lex));
+
+$edits = array(
+	array(6500, 0, "4 + "),
+	array(6500, 4, ""),
+	array(6500, 1, "(("),
+	array(6500, 2, "("),
+	array(0, 0, "5;"),
+	array(strlen($doc) + 2, 0, "6 +"),
+);
+foreach ($edits as $e) {
+	list($start, $len, $text) = $e;
+	$doc = substr($doc, 0, $start) . $text . substr($doc, $start + $len);
+	$r = $p->reparse($start, $len, $text, $lex);
+	var_dump($r, $r === $p->validate($doc, $lex));
+}
+
+/* A paren free tail, then a new lexer without parens. The snapshots
+	of the old lexer mustn't be reused, even if the new state machine
+	lands at the same address. */
+$tail = str_repeat("1 + 2;\n", 1000);
+$r = $p->reparse(strlen($doc) - 3, 3, $tail, $lex);
+$doc = substr($doc, 0, strlen($doc) - 3) . $tail;
+var_dump($r, $r === $p->validate($doc, $lex));
+
+unset($lex);
+$lex = new Lexer;
+$lex->push("[+]", $p->tokenId("'+'"));
+$lex->push("[-]", $p->tokenId("'-'"));
+$lex->push(";", $p->tokenId("';'"));
+$lex->push("\\d+", $p->tokenId("INTEGER"));
+$lex->push("\\s+", Token::SKIP);
+$lex->build();
+$r = $p->reparse(strlen($doc), 0, "", $lex);
+var_dump($r, $r === $p->validate($doc, $lex));
+
+try {
+	$p->reparse(strlen($doc) + 1, 0, "", $lex);
+} catch (ParserException $e) {
+	echo $e->getMessage(), "\n";
+}
+
+/* The range parsed again is reported with its reductions, the rest of
+	the parse is the same as before. */
+$r = $p->reparse(0, strlen($doc), "1;\n2 - 3;\n", $lex, $red);
+var_dump($r, $red["start"], $red["end"], implode(" ", $red["reductions"]));
+
+$doc = str_repeat("1;\n", 1000);
+$p->reparse(0, 10, $doc, $lex);
+$r = $p->reparse(1200, 1, "2 + 3", $lex, $red);
+var_dump($r, $red["start"], $red["end"], count($red["reductions"]), implode(" ", array_slice($red["reductions"], 175, 8)));
+$r = $p->reparse(1200, 5, "2 +", $lex, $red);
+var_dump($r, $red["start"], $red["end"], count($red["reductions"]));
+
+?>
+==DONE==
+--EXPECT--
+bool(true)
+bool(true)
+bool(true)
+bool(true)
+bool(true)
+bool(false)
+bool(true)
+bool(true)
+bool(true)
+bool(true)
+bool(true)
+bool(false)
+bool(true)
+bool(true)
+bool(true)
+bool(false)
+bool(true)
+Invalid edit range 20003, 0
+bool(true)
+int(0)
+int(10)
+string(17) "1 7 3 2 7 7 5 3 2"
+bool(true)
+int(1024)
+int(2052)
+int(1026)
+string(15) "3 2 7 7 4 3 2 7"
+bool(false)
+int(1024)
+int(1203)
+int(178)
+==DONE==
@@ -0,0 +1,84 @@
+--TEST--
+Skip unit reductions without actions
+--SKIPIF--
+<?php if (!extension_loaded("parle")) print "skip"; ?>
+--FILE--
+<?php 
+
+use Parle\Parser;
+use Parle\Lexer;
+use Parle\Token;
+
+function calc($skip_units, $in)
+{
+	$p = new Parser;
+	$p->token("INTEGER");
+	$p->push("start", "exp");
+	$add_idx = $p->push("exp", "exp '+' term");
+	$p->push("exp", "term");
+	$mul_idx = $p->push("term", "term '*' factor");
+	$p->push("term", "factor");
+	$int_idx = $p->push("factor", "INTEGER");
+	$p->push("factor", "'(' exp ')'");
+
+	/* INTEGER has an action, exp: term and term: factor don't. */
+	if ($skip_units) {
+		$p->build(array($int_idx));
+	} else {
+		$p->build();
+	}
+
+	$lex = new Lexer;
+	$lex->push("[+]", $p->tokenId("'+'"));
+	$lex->push("[*]", $p->tokenId("'*'"));
+	$lex->push("[(]", $p->tokenId("'('"));
+	$lex->push("[)]", $p->tokenId("')'"));
+	$lex->push("\\d+", $p->tokenId("INTEGER"));
+	$lex->push("\\s+", Token::SKIP);
+	$lex->build();
+
+	$p->consume($in, $lex);
+
+	$vals = array();
+	$reductions = 0;
+	while (Parser::ACTION_ERROR != $p->action() && Parser::ACTION_ACCEPT != $p->action()) {
+		if (Parser::ACTION_REDUCE == $p->action()) {
+			$reductions++;
+			switch ($p->reduceId()) {
+				case $int_idx:
+					$vals[] = (int)$p->sigil(0);
+					break;
+				case $add_idx:
+					echo $p->sigil(0), " + ", $p->sigil(2), "\n";
+					$vals[] = array_pop($vals) + array_pop($vals);
+					break;
+				case $mul_idx:
+					echo $p->sigil(0), " * ", $p->sigil(2), "\n";
+					$vals[] = array_pop($vals) * array_pop($vals);
+					break;
+			}
+		}
+		$p->advance();
+	}
+
+	echo "result ", array_pop($vals), ", $reductions reductions\n";
+	var_dump($p->validate("2 + * 3", $lex));
+}
+
+calc(false, "2 + 3 * (4 + 1)");
+calc(true, "2 + 3 * (4 + 1)");
+
+?>
+==DONE==
+--EXPECT--
+4 + 1
+3 * (4 + 1)
+2 + 3 * (4 + 1)
+result 17, 14 reductions
+bool(false)
+4 + 1
+3 * (4 + 1)
+2 + 3 * (4 + 1)
+result 17, 10 reductions
+bool(false)
+==DONE==
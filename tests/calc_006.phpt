@@ -0,0 +1,69 @@
+--TEST--
+Advance the parser until a reduction with an action
+--SKIPIF--
+<?php if (!extension_loaded("parle")) print "skip"; ?>
+--FILE--
+<?php 
+
+use Parle\Parser;
+use Parle\Lexer;
+use Parle\Token;
+
+$p = new Parser;
+$p->token("INTEGER");
+$p->push("start", "exp");
+$add_idx = $p->push("exp", "exp '+' term");
+$p->push("exp", "term");
+$mul_idx = $p->push("term", "term '*' factor");
+$p->push("term", "factor");
+$int_idx = $p->push("factor", "INTEGER");
+$p->push("factor", "'(' exp ')'");
+$p->build();
+
+$lex = new Lexer;
+$lex->push("[+]", $p->tokenId("'+'"));
+$lex->push("[*]", $p->tokenId("'*'"));
+$lex->push("[(]", $p->tokenId("'('"));
+$lex->push("[)]", $p->tokenId("')'"));
+$lex->push("\\d+", $p->tokenId("INTEGER"));
+$lex->push("\\s+", Token::SKIP);
+$lex->build();
+
+$ids = array($int_idx, $add_idx, $mul_idx);
+
+foreach (array("2 + 3 * (4 + 1)", "2 + * 3") as $in) {
+	$p->consume($in, $lex);
+
+	$vals = array();
+	$n = 0;
+	for ($act = $p->action(); Parser::ACTION_ERROR != $act && Parser::ACTION_ACCEPT != $act; $act = $p->advanceUntil($ids)) {
+		$n++;
+		if (Parser::ACTION_REDUCE != $act) {
+			continue;
+		}
+		switch ($p->reduceId()) {
+			case $int_idx:
+				$vals[] = (int)$p->sigil(0);
+				break;
+			case $add_idx:
+				$vals[] = array_pop($vals) + array_pop($vals);
+				break;
+			case $mul_idx:
+				$vals[] = array_pop($vals) * array_pop($vals);
+				break;
+		}
+	}
+
+	if (Parser::ACTION_ACCEPT == $act) {
+		echo "$in = ", array_pop($vals), " after $n iterations\n";
+	} else {
+		echo "$in: error after $n iterations\n";
+	}
+}
+
+?>
+==DONE==
+--EXPECT--
+2 + 3 * (4 + 1) = 17 after 8 iterations
+2 + * 3: error after 2 iterations
+==DONE==
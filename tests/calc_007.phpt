@@ -0,0 +1,64 @@
+--TEST--
+Validate and parse many inputs at once
+--SKIPIF--
+<?php if (!extension_loaded("parle")) print "skip"; ?>
+--FILE--
+<?php 
+
+use Parle\Parser;
+use Parle\Lexer;
+use Parle\Token;
+
+$p = new Parser;
+$p->token("INTEGER");
+$p->push("start", "exp");
+$p->push("exp", "exp '+' term");
+$p->push("exp", "term");
+$p->push("term", "term '*' factor");
+$p->push("term", "factor");
+$p->push("factor", "INTEGER");
+$p->push("factor", "'(' exp ')'");
+$p->build();
+
+$lex = new Lexer;
+$lex->push("[+]", $p->tokenId("'+'"));
+$lex->push("[*]", $p->tokenId("'*'"));
+$lex->push("[(]", $p->tokenId("'('"));
+$lex->push("[)]", $p->tokenId("')'"));
+$lex->push("\\d+", $p->tokenId("INTEGER"));
+$lex->push("\\s+", Token::SKIP);
+$lex->build();
+
+$in = array("a" => "1 + 2", 5 => "1 +", "3", "b" => "2 * (3)", "x");
+
+var_dump($p->validateMany($in, $lex));
+
+foreach ($p->parseMany($in, $lex) as $k => $r) {
+	echo "$k: ", false === $r ? "error" : implode(" ", $r), "\n";
+}
+
+var_dump($p->validateMany(array(), $lex));
+
+?>
+==DONE==
+--EXPECT--
+array(5) {
+  ["a"]=>
+  bool(true)
+  [5]=>
+  bool(false)
+  [6]=>
+  bool(true)
+  ["b"]=>
+  bool(true)
+  [7]=>
+  bool(false)
+}
+a: 5 4 2 5 4 1
+5: error
+6: 5 4 2
+b: 5 4 5 4 2 6 3 2
+7: error
+array(0) {
+}
+==DONE==
@@ -0,0 +1,65 @@
+--TEST--
+Validate, parse and count on the thread pool
+--SKIPIF--
+<?php if (!extension_loaded("parle")) print "skip"; ?>
+--INI--
+parle.threads=4
+--FILE--
+<?php 
+
+use Parle\Parser;
+use Parle\Lexer;
+use Parle\ParserException;
+use Parle\Token;
+
+$p = new Parser;
+$p->token("INTEGER");
+$p->push("start", "exp");
+$p->push("exp", "exp '+' term");
+$p->push("exp", "term");
+$p->push("term", "term '*' factor");
+$p->push("term", "factor");
+$p->push("factor", "INTEGER");
+$p->push("factor", "'(' exp ')'");
+$p->build();
+
+$lex = new Lexer;
+$lex->push("[+]", $p->tokenId("'+'"));
+$lex->push("[*]", $p->tokenId("'*'"));
+$lex->push("[(]", $p->tokenId("'('"));
+$lex->push("[)]", $p->tokenId("')'"));
+$lex->push("\\d+", $p->tokenId("INTEGER"));
+$lex->push("\\s+", Token::SKIP);
+$lex->build();
+
+$in = array("a" => "1 + 2", 5 => "1 +", "3", "b" => "2 * (3)", "x");
+for ($i = 0; $i < 1000; $i++) {
+	$in[] = str_repeat("($i + 1) * ", $i % 5) . ($i % 3 ? "$i" : "+");
+}
+
+foreach (array(2, 3, 64) as $threads) {
+	var_dump($p->validateMany($in, $lex, $threads) === $p->validateMany($in, $lex));
+	var_dump($p->parseMany($in, $lex, $threads) === $p->parseMany($in, $lex));
+}
+
+$text = str_repeat("(1 + 22) * 333\n", 20000);
+var_dump($lex->countTokens($text, 8) === $lex->countTokens($text));
+
+try {
+	$p->validateMany($in, $lex, 0);
+} catch (ParserException $e) {
+	echo $e->getMessage(), "\n";
+}
+
+?>
+==DONE==
+--EXPECT--
+bool(true)
+bool(true)
+bool(true)
+bool(true)
+bool(true)
+bool(true)
+bool(true)
+Invalid thread count 0
+==DONE==
@@ -0,0 +1,79 @@
+--TEST--
+Clone parsers
+--SKIPIF--
+<?php if (!extension_loaded("parle")) print "skip"; ?>
+--FILE--
+<?php 
+
+use Parle\Parser;
+use Parle\ParserException;
+use Parle\Lexer;
+use Parle\Token;
+
+$p = new Parser;
+$p->token("INTEGER");
+$p->push("start", "exp");
+$p->push("exp", "exp '+' term");
+$p->push("exp", "term");
+$p->push("term", "term '*' factor");
+$p->push("term", "factor");
+$p->push("factor", "INTEGER");
+$p->push("factor", "'(' exp ')'");
+
+/* Not built yet, the clone gets a copy of the rules. */
+$m = clone $p;
+$m->push("exp", "exp '-' term");
+$m->build();
+$p->build();
+
+try {
+	$p->tokenId("'-'");
+} catch (ParserException $e) {
+	echo $e->getMessage(), "\n";
+}
+var_dump($m->tokenId("'-'") > 0);
+
+$lex = new Lexer;
+$lex->push("[+]", $p->tokenId("'+'"));
+$lex->push("[*]", $p->tokenId("'*'"));
+$lex->push("[(]", $p->tokenId("'('"));
+$lex->push("[)]", $p->tokenId("')'"));
+$lex->push("\\d+", $p->tokenId("INTEGER"));
+$lex->push("\\s+", Token::SKIP);
+$lex->build();
+
+/* Built, the clone shares the grammar. */
+$q = clone $p;
+unset($p);
+var_dump($q->validate("1 + 2 * (3)", $lex));
+var_dump($q->validate("1 + + 2", $lex));
+
+/* A push mode parse is continued independently. */
+function push(Parser $p, $id, $val)
+{
+	$act = $p->pushToken($id, $val);
+	while (Parser::ACTION_REDUCE == $act) {
+		$p->advance();
+		$act = $p->action();
+	}
+	return $act;
+}
+
+$int = $q->tokenId("INTEGER");
+push($q, $int, "1");
+push($q, $q->tokenId("'+'"), "+");
+$r = clone $q;
+push($q, $int, "2");
+var_dump(Parser::ACTION_ACCEPT == push($q, 0, ""));
+var_dump(Parser::ACTION_ERROR == push($r, 0, ""));
+
+?>
+==DONE==
+--EXPECT--
+Unknown token ''-''.
+bool(true)
+bool(true)
+bool(false)
+bool(true)
+bool(true)
+==DONE==
@@ -0,0 +1,64 @@
+--TEST--
+Parser::stats() reports table and input sizes
+--SKIPIF--
+<?php if (!extension_loaded("parle")) print "skip"; ?>
+--FILE--
+<?php 
+
+use Parle\Parser;
+use Parle\ParserException;
+use Parle\Lexer;
+use Parle\Token;
+
+$p = new Parser;
+$p->token("INTEGER");
+$p->push("start", "exp");
+$p->push("exp", "exp '+' term");
+$p->push("exp", "term");
+$p->push("term", "term '*' factor");
+$p->push("term", "factor");
+$p->push("factor", "INTEGER");
+$p->push("factor", "'(' exp ')'");
+
+try {
+	$p->stats();
+} catch (ParserException $e) {
+	echo $e->getMessage(), "\n";
+}
+
+$p->build();
+
+$st = $p->stats();
+var_dump($st["states"], $st["terminals"], $st["nonTerminals"], $st["productions"]);
+/* An action and a parameter per cell. */
+var_dump($st["bytes"]["table"] == $st["states"] * ($st["terminals"] + $st["nonTerminals"]) * 2 * PHP_INT_SIZE);
+var_dump($st["bytes"]["rules"] > 0, $st["bytes"]["input"], $st["bytes"]["results"]);
+
+$lex = new Lexer;
+$lex->push("[+]", $p->tokenId("'+'"));
+$lex->push("[*]", $p->tokenId("'*'"));
+$lex->push("[(]", $p->tokenId("'('"));
+$lex->push("[)]", $p->tokenId("')'"));
+$lex->push("\\d+", $p->tokenId("INTEGER"));
+$lex->push("\\s+", Token::SKIP);
+$lex->build();
+
+$p->consume(str_repeat("1 + ", 1000) . "1", $lex);
+$st = $p->stats();
+var_dump($st["bytes"]["input"] > 4000, $st["bytes"]["results"] > 0);
+
+?>
+==DONE==
+--EXPECT--
+Parser state machine is not ready
+int(13)
+int(6)
+int(4)
+int(7)
+bool(true)
+bool(true)
+int(0)
+int(0)
+bool(true)
+bool(true)
+==DONE==
@@ -31,36 +31,52 @@ while (Token::EOI != $tok->id) {
 ?>
 ==DONE==
 --EXPECTF--
-object(Parle\Token)#%d (3) {
+object(Parle\Token)#%d (5) {
   ["id"]=>
   int(1)
   ["value"]=>
   string(6) "$hello"
   ["offset"]=>
   int(0)
+  ["line"]=>
+  int(1)
+  ["column"]=>
+  int(1)
 }
-object(Parle\Token)#3 (3) {
+object(Parle\Token)#3 (5) {
   ["id"]=>
   int(2)
   ["value"]=>
   string(1) "="
   ["offset"]=>
   int(6)
+  ["line"]=>
+  int(1)
+  ["column"]=>
+  int(7)
 }
-object(Parle\Token)#%d (3) {
+object(Parle\Token)#%d (5) {
   ["id"]=>
   int(3)
   ["value"]=>
   string(2) "42"
   ["offset"]=>
   int(7)
+  ["line"]=>
+  int(1)
+  ["column"]=>
+  int(8)
 }
-object(Parle\Token)#3 (3) {
+object(Parle\Token)#3 (5) {
   ["id"]=>
   int(4)
   ["value"]=>
   string(1) ";"
   ["offset"]=>
   int(9)
+  ["line"]=>
+  int(1)
+  ["column"]=>
+  int(10)
 }
 ==DONE==
@@ -40,36 +40,52 @@ foreach ($nums as $in) {
 ?>
 ==DONE==
 --EXPECTF--
-object(Parle\Token)#%d (3) {
+object(Parle\Token)#%d (5) {
   ["id"]=>
   int(4)
   ["value"]=>
   string(4) "0x42"
   ["offset"]=>
   int(0)
+  ["line"]=>
+  int(1)
+  ["column"]=>
+  int(1)
 }
-object(Parle\Token)#%d (3) {
+object(Parle\Token)#%d (5) {
   ["id"]=>
   int(1)
   ["value"]=>
   string(8) "0b010101"
   ["offset"]=>
   int(5)
+  ["line"]=>
+  int(1)
+  ["column"]=>
+  int(6)
 }
-object(Parle\Token)#%d (3) {
+object(Parle\Token)#%d (5) {
   ["id"]=>
   int(2)
   ["value"]=>
   string(3) "075"
   ["offset"]=>
   int(14)
+  ["line"]=>
+  int(1)
+  ["column"]=>
+  int(15)
 }
-object(Parle\Token)#%d (3) {
+object(Parle\Token)#%d (5) {
   ["id"]=>
   int(3)
   ["value"]=>
   string(2) "24"
   ["offset"]=>
   int(18)
+  ["line"]=>
+  int(1)
+  ["column"]=>
+  int(19)
 }
 ==DONE==
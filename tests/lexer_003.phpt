@@ -85,124 +85,184 @@ while (Token::EOI != $tok->id) {
 ?>
 ==DONE==
 --EXPECTF--
-object(Parle\Token)#%d (3) {
+object(Parle\Token)#%d (5) {
   ["id"]=>
   int(42)
   ["value"]=>
   string(1) "{"
   ["offset"]=>
   int(0)
+  ["line"]=>
+  int(1)
+  ["column"]=>
+  int(1)
 }
-object(Parle\Token)#%d (3) {
+object(Parle\Token)#%d (5) {
   ["id"]=>
   int(46)
   ["value"]=>
   string(5) ""key""
   ["offset"]=>
   int(5)
+  ["line"]=>
+  int(2)
+  ["column"]=>
+  int(4)
 }
-object(Parle\Token)#%d (3) {
+object(Parle\Token)#%d (5) {
   ["id"]=>
   int(44)
   ["value"]=>
   string(1) "["
   ["offset"]=>
   int(12)
+  ["line"]=>
+  int(2)
+  ["column"]=>
+  int(11)
 }
-object(Parle\Token)#%d (3) {
+object(Parle\Token)#%d (5) {
   ["id"]=>
   int(47)
   ["value"]=>
   string(15) ""qelque choose""
   ["offset"]=>
   int(18)
+  ["line"]=>
+  int(3)
+  ["column"]=>
+  int(6)
 }
-object(Parle\Token)#%d (3) {
+object(Parle\Token)#%d (5) {
   ["id"]=>
   int(48)
   ["value"]=>
   string(2) "42"
   ["offset"]=>
   int(39)
+  ["line"]=>
+  int(4)
+  ["column"]=>
+  int(7)
 }
-object(Parle\Token)#%d (3) {
+object(Parle\Token)#%d (5) {
   ["id"]=>
   int(47)
   ["value"]=>
   string(8) ""füße""
   ["offset"]=>
   int(54)
+  ["line"]=>
+  int(5)
+  ["column"]=>
+  int(15)
 }
-object(Parle\Token)#%d (3) {
+object(Parle\Token)#%d (5) {
   ["id"]=>
   int(45)
   ["value"]=>
   string(1) "]"
   ["offset"]=>
   int(66)
+  ["line"]=>
+  int(7)
+  ["column"]=>
+  int(5)
 }
-object(Parle\Token)#%d (3) {
+object(Parle\Token)#%d (5) {
   ["id"]=>
   int(46)
   ["value"]=>
   string(5) ""obj""
   ["offset"]=>
   int(72)
+  ["line"]=>
+  int(7)
+  ["column"]=>
+  int(11)
 }
-object(Parle\Token)#%d (3) {
+object(Parle\Token)#%d (5) {
   ["id"]=>
   int(42)
   ["value"]=>
   string(1) "{"
   ["offset"]=>
   int(79)
+  ["line"]=>
+  int(8)
+  ["column"]=>
+  int(7)
 }
-object(Parle\Token)#%d (3) {
+object(Parle\Token)#%d (5) {
   ["id"]=>
   int(46)
   ["value"]=>
   string(6) ""prop""
   ["offset"]=>
   int(87)
+  ["line"]=>
+  int(8)
+  ["column"]=>
+  int(15)
 }
-object(Parle\Token)#%d (3) {
+object(Parle\Token)#%d (5) {
   ["id"]=>
   int(48)
   ["value"]=>
   string(2) "12"
   ["offset"]=>
   int(95)
+  ["line"]=>
+  int(10)
+  ["column"]=>
+  int(2)
 }
-object(Parle\Token)#%d (3) {
+object(Parle\Token)#%d (5) {
   ["id"]=>
   int(43)
   ["value"]=>
   string(1) "}"
   ["offset"]=>
   int(101)
+  ["line"]=>
+  int(10)
+  ["column"]=>
+  int(8)
 }
-object(Parle\Token)#%d (3) {
+object(Parle\Token)#%d (5) {
   ["id"]=>
   int(46)
   ["value"]=>
   string(6) ""some""
   ["offset"]=>
   int(107)
+  ["line"]=>
+  int(10)
+  ["column"]=>
+  int(14)
 }
-object(Parle\Token)#%d (3) {
+object(Parle\Token)#%d (5) {
   ["id"]=>
   int(50)
   ["value"]=>
   string(4) "null"
   ["offset"]=>
   int(115)
+  ["line"]=>
+  int(13)
+  ["column"]=>
+  int(4)
 }
-object(Parle\Token)#%d (3) {
+object(Parle\Token)#%d (5) {
   ["id"]=>
   int(43)
   ["value"]=>
   string(1) "}"
   ["offset"]=>
   int(121)
+  ["line"]=>
+  int(13)
+  ["column"]=>
+  int(10)
 }
 ==DONE==
@@ -36,15 +36,19 @@ while (Token::EOI != $tok->id) {
 ?>
 ==DONE==
 --EXPECTF--
-object(Parle\Token)#%d (3) {
+object(Parle\Token)#%d (5) {
   ["id"]=>
   int(2)
   ["value"]=>
   string(3) "cmd"
   ["offset"]=>
   int(4)
+  ["line"]=>
+  int(2)
+  ["column"]=>
+  int(1)
 }
-object(Parle\Token)#%d (3) {
+object(Parle\Token)#%d (5) {
   ["id"]=>
   int(100)
   ["value"]=>
@@ -52,32 +56,48 @@ object(Parle\Token)#%d (3) {
 "
   ["offset"]=>
   int(7)
+  ["line"]=>
+  int(2)
+  ["column"]=>
+  int(4)
 }
-object(Parle\Token)#%d (3) {
+object(Parle\Token)#%d (5) {
   ["id"]=>
   int(50)
   ["value"]=>
   string(1) "a"
   ["offset"]=>
   int(8)
+  ["line"]=>
+  int(3)
+  ["column"]=>
+  int(1)
 }
-object(Parle\Token)#%d (3) {
+object(Parle\Token)#%d (5) {
   ["id"]=>
   int(100)
   ["value"]=>
   string(1) " "
   ["offset"]=>
   int(9)
+  ["line"]=>
+  int(3)
+  ["column"]=>
+  int(2)
 }
-object(Parle\Token)#%d (3) {
+object(Parle\Token)#%d (5) {
   ["id"]=>
   int(4)
   ["value"]=>
   string(3) "cmd"
   ["offset"]=>
   int(10)
+  ["line"]=>
+  int(3)
+  ["column"]=>
+  int(3)
 }
-object(Parle\Token)#%d (3) {
+object(Parle\Token)#%d (5) {
   ["id"]=>
   int(100)
   ["value"]=>
@@ -85,32 +105,48 @@ object(Parle\Token)#%d (3) {
 "
   ["offset"]=>
   int(13)
+  ["line"]=>
+  int(3)
+  ["column"]=>
+  int(6)
 }
-object(Parle\Token)#%d (3) {
+object(Parle\Token)#%d (5) {
   ["id"]=>
   int(3)
   ["value"]=>
   string(3) "cmd"
   ["offset"]=>
   int(14)
+  ["line"]=>
+  int(4)
+  ["column"]=>
+  int(1)
 }
-object(Parle\Token)#%d (3) {
+object(Parle\Token)#%d (5) {
   ["id"]=>
   int(100)
   ["value"]=>
   string(1) " "
   ["offset"]=>
   int(17)
+  ["line"]=>
+  int(4)
+  ["column"]=>
+  int(4)
 }
-object(Parle\Token)#%d (3) {
+object(Parle\Token)#%d (5) {
   ["id"]=>
   int(50)
   ["value"]=>
   string(5) "again"
   ["offset"]=>
   int(18)
+  ["line"]=>
+  int(4)
+  ["column"]=>
+  int(5)
 }
-object(Parle\Token)#%d (3) {
+object(Parle\Token)#%d (5) {
   ["id"]=>
   int(100)
   ["value"]=>
@@ -118,29 +154,45 @@ object(Parle\Token)#%d (3) {
 "
   ["offset"]=>
   int(23)
+  ["line"]=>
+  int(4)
+  ["column"]=>
+  int(10)
 }
-object(Parle\Token)#%d (3) {
+object(Parle\Token)#%d (5) {
   ["id"]=>
   int(50)
   ["value"]=>
   string(7) "another"
   ["offset"]=>
   int(24)
+  ["line"]=>
+  int(5)
+  ["column"]=>
+  int(1)
 }
-object(Parle\Token)#%d (3) {
+object(Parle\Token)#%d (5) {
   ["id"]=>
   int(100)
   ["value"]=>
   string(1) " "
   ["offset"]=>
   int(31)
+  ["line"]=>
+  int(5)
+  ["column"]=>
+  int(8)
 }
-object(Parle\Token)#%d (3) {
+object(Parle\Token)#%d (5) {
   ["id"]=>
   int(4)
   ["value"]=>
   string(3) "cmd"
   ["offset"]=>
   int(32)
+  ["line"]=>
+  int(5)
+  ["column"]=>
+  int(9)
 }
 ==DONE==
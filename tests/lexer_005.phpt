@@ -0,0 +1,40 @@
+--TEST--
+Replace and split using the lexer
+--SKIPIF--
+<?php if (!extension_loaded("parle")) print "skip"; ?>
+--FILE--
+<?php 
+
+use Parle\Lexer;
+use Parle\Token;
+
+$lex = new Lexer;
+$lex->push("[a-z]+", 1);
+$lex->push("\\d+", 2);
+$lex->push("\\s+", Token::SKIP);
+$lex->build();
+
+var_dump($lex->replace("abc 12  de 3", array(2 => "#", 1 => function ($tok) { return strtoupper($tok->value); })));
+var_dump($lex->replace("ab 1", function ($tok) { return "<{$tok->id}@{$tok->offset}>"; }));
+var_dump($lex->replace("ab,1", array(1 => "w")));
+var_dump($lex->replace("ab 1", array(42 => "x")));
+var_dump($lex->split("abc 12,de"));
+
+?>
+==DONE==
+--EXPECT--
+string(11) "ABC #  DE #"
+string(11) "<1@0> <2@3>"
+string(3) "w,1"
+string(4) "ab 1"
+array(4) {
+  [0]=>
+  string(3) "abc"
+  [1]=>
+  string(2) "12"
+  [2]=>
+  string(1) ","
+  [3]=>
+  string(2) "de"
+}
+==DONE==
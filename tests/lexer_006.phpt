@@ -0,0 +1,48 @@
+--TEST--
+Count tokens without materializing them
+--SKIPIF--
+<?php if (!extension_loaded("parle")) print "skip"; ?>
+--FILE--
+<?php 
+
+use Parle\Lexer;
+use Parle\Token;
+
+$lex = new Lexer;
+$lex->push("[a-z]+", 1);
+$lex->push("\\d+", 2);
+$lex->push("\\s+", Token::SKIP);
+$lex->build();
+
+var_dump($lex->countTokens("ab 12 cd ,x"));
+var_dump($lex->countTokens(""));
+
+?>
+==DONE==
+--EXPECT--
+array(3) {
+  [1]=>
+  array(2) {
+    ["count"]=>
+    int(3)
+    ["bytes"]=>
+    int(5)
+  }
+  [2]=>
+  array(2) {
+    ["count"]=>
+    int(1)
+    ["bytes"]=>
+    int(2)
+  }
+  [-1]=>
+  array(2) {
+    ["count"]=>
+    int(1)
+    ["bytes"]=>
+    int(1)
+  }
+}
+array(0) {
+}
+==DONE==
@@ -0,0 +1,82 @@
+--TEST--
+Filter tokens in the lexer and the parser
+--SKIPIF--
+<?php if (!extension_loaded("parle")) print "skip"; ?>
+--FILE--
+<?php 
+
+use Parle\Parser;
+use Parle\Lexer;
+use Parle\Token;
+
+$p = new Parser;
+$p->token("WORD");
+$p->token("COMMENT");
+$p->push("start", "words");
+$p->push("words", "words WORD");
+$word_idx = $p->push("words", "WORD");
+$p->build();
+
+$lex = new Lexer;
+$lex->push("[a-z]+", $p->tokenId("WORD"));
+$lex->push("#[^\\n]*", $p->tokenId("COMMENT"));
+$lex->push("\\s+", Token::SKIP);
+$lex->build();
+
+$in = "foo # a comment\nbar # another one";
+
+$lex->consume($in);
+$lex->advance();
+$tok = $lex->getToken();
+while (Token::EOI != $tok->id) {
+	echo $tok->id == $p->tokenId("COMMENT") ? "comment" : "word", " ", $tok->value, "\n";
+	$lex->advance();
+	$tok = $lex->getToken();
+}
+
+var_dump($p->validate($in, $lex));
+
+$lex->setFilter(array($p->tokenId("COMMENT")));
+
+$lex->consume($in);
+$lex->advance();
+$tok = $lex->getToken();
+while (Token::EOI != $tok->id) {
+	echo "filtered ", $tok->value, "\n";
+	$lex->advance();
+	$tok = $lex->getToken();
+}
+
+var_dump($p->validate($in, $lex));
+
+$p->consume($in, $lex);
+do {
+	switch ($p->action()) {
+		case Parser::ACTION_ERROR:
+			throw new Exception("Error");
+		case Parser::ACTION_REDUCE:
+			if ($p->reduceId() == $word_idx) {
+				echo "first word ", $p->sigil(0), "\n";
+			}
+			break;
+	}
+	$p->advance();
+} while (Parser::ACTION_ACCEPT != $p->action());
+
+$lex->setFilter(array());
+var_dump($p->validate($in, $lex));
+
+?>
+==DONE==
+--EXPECT--
+word foo
+comment # a comment
+word bar
+comment # another one
+bool(false)
+filtered foo
+filtered bar
+bool(true)
+first word foo
+bool(false)
+==DONE==
@@ -0,0 +1,99 @@
+--TEST--
+Feed the lexer in chunks
+--SKIPIF--
+<?php if (!extension_loaded("parle")) print "skip"; ?>
+--FILE--
+<?php 
+
+use Parle\Lexer;
+use Parle\RLexer;
+use Parle\Token;
+
+$lex = new Lexer;
+$lex->push("ab", 1);
+$lex->push("abcd", 2);
+$lex->push("c", 3);
+$lex->push("\\d+", 4);
+$lex->push("\\s+", Token::SKIP);
+$lex->build();
+
+foreach (array("ab a", "bcd 12", "345 abc", " a", "b") as $chunk) {
+	echo "chunk '$chunk':";
+	foreach ($lex->feed($chunk) as $tok) {
+		echo " {$tok->id}:{$tok->value}@{$tok->offset}";
+	}
+	echo "\n";
+}
+echo "final:";
+foreach ($lex->feed("", true) as $tok) {
+	echo " {$tok->id}:{$tok->value}@{$tok->offset}";
+}
+echo "\n";
+
+/* A skipped token between two others, which could still grow into a
+	longer skipped token with the next chunk. */
+$lex = new Lexer;
+$lex->push("x", 1);
+$lex->push("z", 2);
+$lex->push("w", Token::SKIP);
+$lex->push("y", Token::SKIP);
+$lex->push("yzzq", Token::SKIP);
+$lex->build();
+
+foreach (array("xwyzz", "qx") as $chunk) {
+	echo "chunk '$chunk':";
+	foreach ($lex->feed($chunk) as $tok) {
+		echo " {$tok->id}:{$tok->value}@{$tok->offset}";
+	}
+	echo "\n";
+}
+echo "final:";
+foreach ($lex->feed("", true) as $tok) {
+	echo " {$tok->id}:{$tok->value}@{$tok->offset}";
+}
+echo "\n";
+
+/* Skipped nested comments, which pop the recursive lexer's stack. The
+	tokens after them don't wait for the final chunk. */
+$lex = new RLexer;
+$lex->pushState("COMMENT");
+$lex->push("INITIAL", "[a-z]+", 1, ".");
+$lex->push("INITIAL", "\\s+", Token::SKIP, ".");
+$lex->push("INITIAL", "\\/\\*", Token::SKIP, ">COMMENT");
+$lex->push("COMMENT", "\\/\\*", Token::SKIP, ">COMMENT");
+$lex->push("COMMENT", "\\*\\/", Token::SKIP, "<");
+$lex->push("COMMENT", "(.|\\n)", Token::SKIP, ".");
+$lex->build();
+
+foreach (array("foo /* a /* b */", " c */ bar", " baz ", "/* x", " */ qux") as $chunk) {
+	echo "chunk '$chunk':";
+	foreach ($lex->feed($chunk) as $tok) {
+		echo " {$tok->id}:{$tok->value}@{$tok->offset}";
+	}
+	echo "\n";
+}
+echo "final:";
+foreach ($lex->feed("", true) as $tok) {
+	echo " {$tok->id}:{$tok->value}@{$tok->offset}";
+}
+echo "\n";
+
+?>
+==DONE==
+--EXPECT--
+chunk 'ab a': 1:ab@0
+chunk 'bcd 12': 2:abcd@3
+chunk '345 abc': 4:12345@8
+chunk ' a': 1:ab@14 3:c@16
+chunk 'b':
+final: 1:ab@18
+chunk 'xwyzz': 1:x@0
+chunk 'qx':
+final: 1:x@6
+chunk 'foo /* a /* b */': 1:foo@0
+chunk ' c */ bar':
+chunk ' baz ': 1:bar@22 1:baz@26
+chunk '/* x':
+chunk ' */ qux':
+final: 1:qux@38
+==DONE==
@@ -0,0 +1,143 @@
+--TEST--
+Relex an edited range
+--SKIPIF--
+<?php if (!extension_loaded("parle")) print "skip"; ?>
+--FILE--
+<?php 
+
+use Parle\Lexer;
+use Parle\RLexer;
+use Parle\Token;
+
+function rules(Lexer $lex)
+{
+	$lex->push("[a-z]+", 1);
+	$lex->push("\\d+", 2);
+	$lex->push("\\s+", Token::SKIP);
+	$lex->build();
+}
+
+function dump_relex(array $r)
+{
+	echo "offset {$r["offset"]} oldEnd {$r["oldEnd"]} end {$r["end"]} tokens ", count($r["tokens"]), "\n";
+	foreach ($r["tokens"] as $tok) {
+		if ($tok->value == "bar" || $tok->value == "baz" || $tok->value == "x") {
+			echo "{$tok->id}:{$tok->value}@{$tok->offset}\n";
+		}
+	}
+}
+
+function all_tokens(Lexer $lex)
+{
+	$ret = array();
+	$lex->advance();
+	$tok = $lex->getToken();
+	while (Token::EOI != $tok->id) {
+		$ret[] = "{$tok->id}:{$tok->value}@{$tok->offset}";
+		$lex->advance();
+		$tok = $lex->getToken();
+	}
+	return $ret;
+}
+
+$in = str_repeat("foo 12 ", 400);
+
+$lex = new Lexer;
+rules($lex);
+$lex->consume($in);
+
+dump_relex($lex->relex(2002, 3, "bar baz"));
+dump_relex($lex->relex(0, 3, "x"));
+
+$in = "x" . substr($in, 3, 1999) . "bar baz" . substr($in, 2005);
+$check = new Lexer;
+rules($check);
+$check->consume($in);
+var_dump(all_tokens($lex) === all_tokens($check));
+
+try {
+	$lex->relex(10, 10000, "");
+} catch (Parle\LexerException $e) {
+	echo $e->getMessage(), "\n";
+}
+
+/* After feed() the offsets are within the whole stream like those of the
+	tokens, the input it dropped can't be edited. */
+$lex = new Lexer;
+rules($lex);
+$lex->feed("foo bar");
+$lex->feed(" baz qux");
+$r = $lex->relex(8, 3, "zap");
+echo "offset {$r["offset"]} oldEnd {$r["oldEnd"]} end {$r["end"]}:";
+foreach ($r["tokens"] as $tok) {
+	echo " {$tok->id}:{$tok->value}@{$tok->offset}";
+}
+echo "\n";
+
+try {
+	$lex->relex(2, 0, "");
+} catch (Parle\LexerException $e) {
+	echo $e->getMessage(), "\n";
+}
+
+/* The input kept by feed() starts inside a string here, it's relexed
+	from the state the lexer was in there. */
+$lex = new RLexer;
+$lex->pushState("STR");
+$lex->push("INITIAL", "[a-z]+", 1, ".");
+$lex->push("INITIAL", "\\s+", Token::SKIP, ".");
+$lex->push("INITIAL", "\"", 3, ">STR");
+$lex->push("STR", "[^\"]+", 4, ".");
+$lex->push("STR", "\"", 5, "<");
+$lex->build();
+$lex->feed("x \"ab");
+$lex->feed("cd\" y");
+$r = $lex->relex(3, 2, "zz");
+echo "offset {$r["offset"]} oldEnd {$r["oldEnd"]} end {$r["end"]}:";
+foreach ($r["tokens"] as $tok) {
+	echo " {$tok->id}:{$tok->value}@{$tok->offset}";
+}
+echo "\n";
+
+/* Pulling tokens goes on where it was if the edit is past the current
+	token, otherwise it starts over. */
+function next_token(Lexer $lex)
+{
+	$lex->advance();
+	$tok = $lex->getToken();
+	return "{$tok->id}:{$tok->value}@{$tok->offset}";
+}
+
+$lex = new Lexer;
+rules($lex);
+$lex->consume(str_repeat("foo 12 ", 400));
+next_token($lex);
+next_token($lex);
+echo next_token($lex), "\n";
+$lex->relex(2002, 3, "bar");
+echo next_token($lex), "\n";
+do {
+	$tok = next_token($lex);
+} while ($lex->getToken()->offset < 2100);
+echo $tok, "\n";
+$lex->relex(2002, 3, "baz");
+echo next_token($lex), "\n";
+
+?>
+==DONE==
+--EXPECT--
+offset 1025 oldEnd 2050 end 2054 tokens 294
+1:bar@2002
+1:baz@2006
+offset 0 oldEnd 1025 end 1023 tokens 293
+1:x@0
+bool(true)
+Invalid edit range 10, 10000
+offset 3 oldEnd 15 end 15: 1:bar@4 1:zap@8 1:qux@12
+Invalid edit range 2, 0
+offset 3 oldEnd 10 end 10: 4:zzcd@3 5:"@7 1:y@9
+1:foo@7
+2:12@11
+1:foo@2100
+1:foo@0
+==DONE==
@@ -0,0 +1,70 @@
+--TEST--
+Peek at upcoming tokens
+--SKIPIF--
+<?php if (!extension_loaded("parle")) print "skip"; ?>
+--FILE--
+<?php 
+
+use Parle\Lexer;
+use Parle\LexerException;
+use Parle\Token;
+
+function tok(Token $tok)
+{
+	echo "{$tok->id}:{$tok->value}@{$tok->offset}\n";
+}
+
+$lex = new Lexer;
+$lex->push("[a-z]+", 1);
+$lex->push("\\d+", 2);
+$lex->push("\\s+", Token::SKIP);
+$lex->build();
+
+$lex->consume("a 1 b");
+tok($lex->peek());
+tok($lex->peek(2));
+
+$lex->advance();
+tok($lex->getToken());
+tok($lex->peek());
+tok($lex->peek(3));
+tok($lex->peek(10));
+
+echo "--\n";
+do {
+	$lex->advance();
+	tok($lex->getToken());
+} while (Token::EOI != $lex->getToken()->id);
+tok($lex->peek());
+
+echo "--\n";
+$lex->restart(2);
+tok($lex->peek());
+$lex->advance();
+tok($lex->getToken());
+
+try {
+	$lex->peek(0);
+} catch (LexerException $e) {
+	echo $e->getMessage(), "\n";
+}
+
+?>
+==DONE==
+--EXPECT--
+1:a@0
+2:1@2
+1:a@0
+2:1@2
+0:@5
+0:@5
+--
+2:1@2
+1:b@4
+0:@5
+0:@5
+--
+2:1@2
+2:1@2
+Invalid lookahead 0
+==DONE==
@@ -0,0 +1,70 @@
+--TEST--
+Token line and column
+--SKIPIF--
+<?php if (!extension_loaded("parle")) print "skip"; ?>
+--FILE--
+<?php 
+
+use Parle\Lexer;
+use Parle\Token;
+
+function tok(Token $tok)
+{
+	echo "{$tok->id}:{$tok->value}@{$tok->offset} {$tok->line}:{$tok->column}\n";
+}
+
+function lexer()
+{
+	$lex = new Lexer;
+	$lex->push("[a-z]+", 1);
+	$lex->push("\\s+", Token::SKIP);
+	$lex->build();
+	return $lex;
+}
+
+$lex = lexer();
+$lex->consume("ab\ncd ef\n\ngh");
+tok($lex->peek(3));
+do {
+	$lex->advance();
+	tok($lex->getToken());
+} while (Token::EOI != $lex->getToken()->id);
+
+echo "--\n";
+$lex = lexer();
+foreach (array("ab\nc", "d ef\n", "\ngh") as $i => $chunk) {
+	foreach ($lex->feed($chunk, 2 == $i) as $t) {
+		tok($t);
+	}
+}
+
+echo "--\n";
+$lex = lexer();
+$lex->consume(str_repeat("ab\n", 3));
+$r = $lex->relex(3, 0, "x\ny ");
+foreach ($r["tokens"] as $t) {
+	tok($t);
+}
+
+?>
+==DONE==
+--EXPECT--
+1:ef@6 2:4
+1:ab@0 1:1
+1:cd@3 2:1
+1:ef@6 2:4
+1:gh@10 4:1
+0:@12 4:3
+--
+1:ab@0 1:1
+1:cd@3 2:1
+1:ef@6 2:4
+1:gh@10 4:1
+--
+1:ab@0 1:1
+1:x@3 2:1
+1:y@5 3:1
+1:ab@7 3:3
+1:ab@10 4:1
+1:ab@13 5:1
+==DONE==
@@ -0,0 +1,54 @@
+--TEST--
+Lex a large input on several threads
+--SKIPIF--
+<?php if (!extension_loaded("parle")) print "skip"; ?>
+--FILE--
+<?php 
+
+use Parle\Lexer;
+use Parle\LexerException;
+use Parle\Token;
+
+$lex = new Lexer;
+$lex->push("[a-z]+", 1);
+$lex->push("\\d+", 2);
+$lex->push("\\s+", Token::SKIP);
+$lex->push("/\\*", "\\*/", 3);
+$lex->build();
+
+/* Comments span lines, so some chunks start in the middle of one. */
+$in = "";
+for ($i = 0; $i < 20000; $i++) {
+	$in .= 0 == $i % 7 ? "/* comment\n$i */\n" : "word $i\n";
+}
+
+$seq = [];
+$lex->consume($in);
+$lex->advance();
+while (Token::EOI != $lex->getToken()->id) {
+	$seq[] = $lex->getToken();
+	$lex->advance();
+}
+
+foreach ([1, 4, 16] as $threads) {
+	$par = $lex->tokenizeParallel($in, $threads);
+	var_dump(count($par) == count($seq) && $par == $seq);
+}
+
+var_dump(count($lex->tokenizeParallel("", 4)));
+
+try {
+	$lex->tokenizeParallel($in, 0);
+} catch (LexerException $e) {
+	echo $e->getMessage(), "\n";
+}
+
+?>
+==DONE==
+--EXPECT--
+bool(true)
+bool(true)
+bool(true)
+int(0)
+Invalid thread count 0
+==DONE==
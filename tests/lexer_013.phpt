@@ -0,0 +1,94 @@
+--TEST--
+Lex several inputs with cursors sharing one lexer
+--SKIPIF--
+<?php if (!extension_loaded("parle")) print "skip"; ?>
+--FILE--
+<?php 
+
+use Parle\Lexer;
+use Parle\RLexer;
+use Parle\LexerCursor;
+use Parle\LexerException;
+use Parle\Token;
+
+function tok(Token $tok)
+{
+	echo "{$tok->id}:{$tok->value}@{$tok->line}:{$tok->column}\n";
+}
+
+$lex = new Lexer;
+$lex->push("[a-z]+", 1);
+$lex->push("\\d+", 2);
+$lex->push("#[^\\n]*", 3);
+$lex->push("\\s+", Token::SKIP);
+$lex->build();
+$lex->setFilter(array(3));
+
+$a = $lex->cursor("a 1 # note\nb");
+$b = $lex->cursor("22 c");
+
+/* The cursors don't depend on the lexer or on each other. */
+unset($lex);
+
+$a->advance();
+$b->advance();
+tok($a->getToken());
+tok($b->getToken());
+tok($a->peek());
+$a->advance();
+$b->advance();
+tok($a->getToken());
+tok($b->getToken());
+$a->advance();
+tok($a->getToken());
+$a->advance();
+tok($a->getToken());
+
+$a->restart(2);
+$a->advance();
+tok($a->getToken());
+
+echo "--\n";
+$rlex = new RLexer;
+$rlex->pushState("STR");
+$rlex->push("INITIAL", "[a-z]+", 1, ".");
+$rlex->push("INITIAL", "[\"]", 2, ">STR:INITIAL");
+$rlex->push("STR", "[^\"]+", 3, ".");
+$rlex->push("STR", "[\"]", 4, "<");
+$rlex->build();
+
+$c = $rlex->cursor("x\"y z\"w");
+do {
+	$c->advance();
+	tok($c->getToken());
+} while (Token::EOI != $c->getToken()->id);
+
+echo "--\n";
+$c = new LexerCursor;
+try {
+	$c->advance();
+} catch (LexerException $e) {
+	echo $e->getMessage(), "\n";
+}
+
+?>
+==DONE==
+--EXPECT--
+1:a@1:1
+2:22@1:1
+2:1@1:3
+2:1@1:3
+1:c@1:4
+1:b@2:1
+0:@2:2
+2:1@1:3
+--
+1:x@1:1
+2:"@1:2
+3:y z@1:3
+4:"@1:6
+1:w@1:7
+0:@1:8
+--
+Lexer state machine is not ready
+==DONE==
@@ -0,0 +1,111 @@
+--TEST--
+Clone lexers and cursors
+--SKIPIF--
+<?php if (!extension_loaded("parle")) print "skip"; ?>
+--FILE--
+<?php 
+
+use Parle\Lexer;
+use Parle\RLexer;
+use Parle\Token;
+
+function tok(Token $tok)
+{
+	echo "{$tok->id}:{$tok->value}@{$tok->offset}\n";
+}
+
+$lex = new Lexer;
+$lex->push("[a-z]+", 1);
+$lex->push("\\d+", 2);
+$lex->push("\\s+", Token::SKIP);
+$lex->build();
+
+$lex->consume("a 1 b 2");
+$lex->advance();
+$lex->peek();
+
+/* The clone continues from the same position, on its own. */
+$c = clone $lex;
+$lex->advance();
+tok($lex->getToken());
+tok($c->getToken());
+$c->advance();
+$c->advance();
+tok($c->getToken());
+
+unset($lex);
+$c->advance();
+tok($c->getToken());
+
+/* Flags aren't shared. */
+$f = clone $c;
+$f->flags(Lexer::FLAG_REGEX_ICASE);
+var_dump($c->flags() == $f->flags());
+
+echo "--\n";
+$u = new Lexer;
+$u->push("[a-z]+", 1);
+$v = clone $u;
+$v->push("\\d+", 2);
+$u->build();
+$v->build();
+$u->consume("7");
+$u->advance();
+tok($u->getToken());
+$v->consume("7");
+$v->advance();
+tok($v->getToken());
+
+echo "--\n";
+$rlex = new RLexer;
+$rlex->pushState("STR");
+$rlex->push("INITIAL", "[a-z]+", 1, ".");
+$rlex->push("INITIAL", "[\"]", 2, ">STR:INITIAL");
+$rlex->push("STR", "[^\"]+", 3, ".");
+$rlex->push("STR", "[\"]", 4, "<");
+$rlex->build();
+
+$rlex->consume("x\"y\"z");
+$rlex->advance();
+$rlex->advance();
+$r = clone $rlex;
+foreach (array($rlex, $r) as $l) {
+	do {
+		$l->advance();
+		tok($l->getToken());
+	} while (Token::EOI != $l->getToken()->id);
+}
+
+echo "--\n";
+$cur = $rlex->cursor("\"q\" w");
+$cur->advance();
+$cur2 = clone $cur;
+$cur->advance();
+tok($cur->getToken());
+$cur2->advance();
+tok($cur2->getToken());
+
+?>
+==DONE==
+--EXPECT--
+2:1@2
+1:a@0
+1:b@4
+2:2@6
+bool(false)
+--
+-1:7@0
+2:7@0
+--
+3:y@2
+4:"@3
+1:z@4
+0:@5
+3:y@2
+4:"@3
+1:z@4
+0:@5
+--
+3:q@1
+3:q@1
+==DONE==
@@ -0,0 +1,77 @@
+--TEST--
+Build lexer states on the thread pool
+--SKIPIF--
+<?php if (!extension_loaded("parle")) print "skip"; ?>
+--INI--
+parle.threads=4
+--FILE--
+<?php 
+
+use Parle\RLexer;
+use Parle\Token;
+use Parle\LexerException;
+
+$lex = new RLexer;
+$lex->pushState("NUM1");
+$lex->pushState("WORD2");
+$lex->pushState("NUM3");
+$lex->pushState("WORD4");
+
+$lex->push("INITIAL", "[a-z]+", 1, ".");
+$lex->push("INITIAL", ",", 100, "NUM1");
+$lex->push("NUM1", "[0-9]+", 2, ".");
+$lex->push("NUM1", ",", 100, "WORD2");
+$lex->push("WORD2", "[a-z]+", 3, ".");
+$lex->push("WORD2", ",", 100, "NUM3");
+$lex->push("NUM3", "[0-9]+", 4, ".");
+$lex->push("NUM3", ",", 100, "WORD4");
+$lex->push("WORD4", "[a-z]+", 5, ".");
+$lex->push("WORD4", ",", 100, "INITIAL");
+$lex->push("*", "\\s+", Token::SKIP, ".");
+
+$lex->build();
+
+$lex->consume("foo, 12, bar, 34, baz, qux, 56");
+$lex->advance();
+$tok = $lex->getToken();
+while (Token::EOI != $tok->id) {
+	echo $tok->id, " ", $tok->value, "\n";
+	$lex->advance();
+	$tok = $lex->getToken();
+}
+
+/* States without rules are reported for the lowest state. */
+$lex = new RLexer;
+$lex->pushState("A");
+$lex->pushState("B");
+$lex->pushState("C");
+$lex->pushState("D");
+$lex->pushState("E");
+$lex->push("INITIAL", "a", 1, "A");
+$lex->push("A", "b", 2, "B");
+$lex->push("B", "c", 3, "INITIAL");
+$lex->push("D", "d", 4, "INITIAL");
+try {
+	$lex->build();
+} catch (LexerException $e) {
+	echo $e->getMessage(), "\n";
+}
+
+?>
+==DONE==
+--EXPECT--
+1 foo
+100 ,
+2 12
+100 ,
+3 bar
+100 ,
+4 34
+100 ,
+5 baz
+100 ,
+1 qux
+100 ,
+2 56
+Lexer states with no rules are not allowed (lexer state 3.)
+==DONE==
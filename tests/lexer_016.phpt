@@ -0,0 +1,85 @@
+--TEST--
+Build the lexer DFA lazily
+--SKIPIF--
+<?php if (!extension_loaded("parle")) print "skip"; ?>
+--FILE--
+<?php 
+
+use Parle\Lexer;
+use Parle\RLexer;
+use Parle\Token;
+use Parle\LexerException;
+
+function lex($lex, $in)
+{
+	$out = array();
+	$lex->consume($in);
+	do {
+		$lex->advance();
+		$tok = $lex->getToken();
+		$out[] = "{$tok->id}:{$tok->value}";
+	} while (Token::EOI != $tok->id);
+
+	return implode(" ", $out);
+}
+
+function rules($lex)
+{
+	foreach (array("if", "else", "elseif", "end", "endif", "while") as $i => $kw) {
+		$lex->push($kw, $i + 1);
+	}
+	$lex->push("[a-z]+", 10);
+	$lex->push("\\d+", 11);
+	$lex->push("\\s+", Token::SKIP);
+}
+
+$in = "if x elseif y else endif while end ends 42 elsewhere";
+
+$eager = new Lexer;
+rules($eager);
+$eager->build();
+
+/* A cache of two rows is dropped after almost every token. */
+$lazy = new Lexer;
+rules($lazy);
+$lazy->build(2);
+
+echo lex($eager, $in), "\n";
+var_dump(lex($lazy, $in) === lex($eager, $in));
+var_dump(lex($lazy, $in) === lex($eager, $in));
+var_dump($lazy->tokenizeParallel($in, 4) == $eager->tokenizeParallel($in, 4));
+
+$cur = $lazy->cursor("while 7");
+$cur->advance();
+$cur->advance();
+echo $cur->getToken()->id, "\n";
+
+/* The NUM state uses $, so it is built in full. */
+$rlex = new RLexer;
+$rlex->pushState("NUM");
+$rlex->push("INITIAL", "[a-z]+", 1, "NUM");
+$rlex->push("NUM", "\\d+$", 2, "INITIAL");
+$rlex->push("NUM", "\\d+", 3, "INITIAL");
+$rlex->push("*", "\\s+", Token::SKIP, ".");
+$rlex->build(1);
+echo lex($rlex, "ab 12 cd 34"), "\n";
+
+$bad = new Lexer;
+$bad->push("a", 1);
+try {
+	$bad->build(-1);
+} catch (LexerException $e) {
+	echo $e->getMessage(), "\n";
+}
+
+?>
+==DONE==
+--EXPECT--
+1:if 10:x 3:elseif 10:y 2:else 5:endif 6:while 4:end 10:ends 11:42 10:elsewhere 0:
+bool(true)
+bool(true)
+bool(true)
+11
+1:ab 3:12 1:cd 2:34 0:
+Invalid lazy state count -1
+==DONE==
@@ -0,0 +1,73 @@
+--TEST--
+Lexer states over parle.lexer_max_states are built lazily
+--SKIPIF--
+<?php if (!extension_loaded("parle")) print "skip"; ?>
+--INI--
+parle.lexer_max_states=64
+--FILE--
+<?php 
+
+use Parle\Lexer;
+use Parle\RLexer;
+use Parle\Token;
+
+function lex($lex, $in)
+{
+	$out = array();
+	$lex->consume($in);
+	do {
+		$lex->advance();
+		$tok = $lex->getToken();
+		$out[] = "{$tok->id}:{$tok->value}";
+	} while (Token::EOI != $tok->id);
+
+	return implode(" ", $out);
+}
+
+/* The full DFA for this has more than 500 rows. */
+$lex = new Lexer;
+$lex->push("[ab]*a[ab]{8}", 1);
+$lex->push("[abc]+", 2);
+$lex->push("\\s+", Token::SKIP);
+$lex->build();
+echo lex($lex, "abababababab c bbbbbbbbbb babbbbbbbb"), "\n";
+var_dump($lex->stats()["states"]["INITIAL"]["lazy"]);
+
+$small = new Lexer;
+$small->push("a", 1);
+$small->push("b", 2);
+$small->build();
+var_dump($small->stats()["states"]);
+
+/* States using $ are always built in full. */
+$rlex = new RLexer;
+$rlex->pushState("END");
+$rlex->push("INITIAL", "[ab]+", 1, "END");
+$rlex->push("END", "[ab]*a[ab]{8}$", 2, "INITIAL");
+$rlex->push("*", "\\s+", Token::SKIP, ".");
+$rlex->build();
+echo lex($rlex, "ab babbbbbbbb"), "\n";
+$st = $rlex->stats()["states"];
+var_dump($st["INITIAL"]["lazy"], $st["END"]["lazy"], $st["END"]["rows"] > 64);
+
+?>
+==DONE==
+--EXPECT--
+2:abababababab 2:c 2:bbbbbbbbbb 1:babbbbbbbb 0:
+bool(true)
+array(1) {
+  ["INITIAL"]=>
+  array(3) {
+    ["rows"]=>
+    int(4)
+    ["lazy"]=>
+    bool(false)
+    ["alphabet"]=>
+    int(2)
+  }
+}
+1:ab 2:babbbbbbbb 0:
+bool(false)
+bool(false)
+bool(true)
+==DONE==
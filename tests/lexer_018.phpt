@@ -0,0 +1,72 @@
+--TEST--
+Keywords are looked up in a table instead of the DFA
+--SKIPIF--
+<?php if (!extension_loaded("parle")) print "skip"; ?>
+--FILE--
+<?php 
+
+use Parle\Lexer;
+use Parle\RLexer;
+use Parle\Token;
+use Parle\LexerException;
+
+function lex($lex, $in)
+{
+	$out = array();
+	$lex->consume($in);
+	do {
+		$lex->advance();
+		$tok = $lex->getToken();
+		$out[] = "{$tok->id}:{$tok->value}";
+	} while (Token::EOI != $tok->id);
+
+	return implode(" ", $out);
+}
+
+$lex = new Lexer;
+$lex->push("[a-zA-Z_][a-zA-Z0-9_]*", 1);
+$lex->push("[0-9]+", 2);
+$lex->push("\\s+", Token::SKIP);
+$lex->keywords(array("SELECT" => 10, "from" => 11, "where" => 12, "noise" => Token::SKIP), 1, true);
+$lex->build();
+echo lex($lex, "select a FROM b Where c selectx froM noise 12 wher"), "\n";
+/* The keywords don't add any rows. */
+var_dump($lex->stats()["states"]["INITIAL"]["rows"]);
+
+try {
+	$lex->keywords(array("select" => 10), 1);
+} catch (LexerException $e) {
+	echo $e->getMessage(), "\n";
+}
+
+/* Case sensitive by default, and applies in every lexer state. */
+$rlex = new RLexer;
+$rlex->pushState("ARGS");
+$rlex->push("INITIAL", "[a-z]+", 1, "ARGS");
+$rlex->push("ARGS", "[a-z]+", 1, "ARGS");
+$rlex->push("ARGS", ";", 2, "INITIAL");
+$rlex->push("*", "\\s+", Token::SKIP, ".");
+$rlex->keywords(array("if" => 3, "end" => 4), 1);
+$rlex->build();
+echo lex($rlex, "if x end; IF end;"), "\n";
+
+foreach (array(array("a" => 3, "A" => 4), array("" => 3), array(5 => 3)) as $map) {
+	try {
+		$bad = new Lexer;
+		$bad->keywords($map, 1, true);
+	} catch (LexerException $e) {
+		echo $e->getMessage(), "\n";
+	}
+}
+
+?>
+==DONE==
+--EXPECT--
+10:select 1:a 11:FROM 1:b 12:Where 1:c 1:selectx 11:froM 2:12 1:wher 0:
+int(5)
+Lexer state machine is readonly
+3:if 1:x 4:end 2:; -1:I -1:F 4:end 2:; 0:
+Duplicate keyword 'a'.
+Empty keyword.
+Keywords must be string keys
+==DONE==
@@ -0,0 +1,39 @@
+--TEST--
+Lexer input is allocated on the Zend heap
+--SKIPIF--
+<?php if (!extension_loaded("parle")) print "skip"; ?>
+--FILE--
+<?php 
+
+use Parle\Lexer;
+use Parle\Token;
+
+$lex = new Lexer;
+$lex->push("[a-z]+", 1);
+$lex->push("\\s+", Token::SKIP);
+$lex->build();
+
+$in = str_repeat("abc ", 1 << 18);
+$before = memory_get_usage();
+$lex->consume($in);
+var_dump(memory_get_usage() - $before >= strlen($in));
+
+$lex->advance();
+$tok = $lex->getToken();
+echo "{$tok->id}:{$tok->value}\n";
+
+$cur = $lex->cursor($in);
+var_dump(memory_get_usage() - $before >= 2 * strlen($in));
+unset($cur);
+
+$lex->consume("x");
+var_dump(memory_get_usage() - $before < strlen($in));
+
+?>
+==DONE==
+--EXPECT--
+bool(true)
+1:abc
+bool(true)
+bool(true)
+==DONE==
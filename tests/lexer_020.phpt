@@ -0,0 +1,50 @@
+--TEST--
+Lexer::stats() reports table and input sizes
+--SKIPIF--
+<?php if (!extension_loaded("parle")) print "skip"; ?>
+--FILE--
+<?php 
+
+use Parle\RLexer;
+use Parle\Token;
+use Parle\LexerException;
+
+$lex = new RLexer;
+try {
+	$lex->stats();
+} catch (LexerException $e) {
+	echo $e->getMessage(), "\n";
+}
+
+$lex->pushState("NUM");
+$lex->push("INITIAL", "[a-z]+", 1, "NUM");
+$lex->push("NUM", "[0-9]+", 2, "INITIAL");
+$lex->push("*", "\\s+", Token::SKIP, ".");
+$lex->build();
+
+$st = $lex->stats();
+var_dump($st["dfas"], $st["rows"], $st["states"]["INITIAL"]["alphabet"], $st["states"]["NUM"]["rows"]);
+var_dump($st["bytes"]["lookup"] >= 2 * 256 * PHP_INT_SIZE);
+var_dump($st["bytes"]["dfa"] >= $st["rows"] * PHP_INT_SIZE);
+var_dump($st["bytes"]["input"], $st["bytes"]["results"]);
+
+$lex->consume(str_repeat("abc 123 ", 1000));
+$lex->advance();
+$st = $lex->stats();
+var_dump($st["bytes"]["input"] > 8000, $st["bytes"]["results"] > 0);
+
+?>
+==DONE==
+--EXPECT--
+Lexer state machine is not ready
+int(2)
+int(8)
+int(2)
+int(4)
+bool(true)
+bool(true)
+int(0)
+int(0)
+bool(true)
+bool(true)
+==DONE==
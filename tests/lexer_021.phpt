@@ -0,0 +1,46 @@
+--TEST--
+Use the thread pool in a forked process
+--SKIPIF--
+<?php if (!extension_loaded("parle")) print "skip"; ?>
+<?php if (!function_exists("pcntl_fork")) print "skip pcntl_fork() not available"; ?>
+--INI--
+parle.threads=4
+--FILE--
+<?php 
+
+use Parle\Lexer;
+use Parle\Token;
+
+$lex = new Lexer;
+$lex->push("[a-z]+", 1);
+$lex->push("\\d+", 2);
+$lex->push("\\s+", Token::SKIP);
+$lex->build();
+
+$in = "";
+for ($i = 0; $i < 20000; $i++) {
+	$in .= "word $i\n";
+}
+
+/* Starts the pool in the parent. */
+$seq = $lex->tokenizeParallel($in, 4);
+var_dump(count($seq));
+
+/* The child only inherits the pool, not its threads. */
+$pid = pcntl_fork();
+if (0 == $pid) {
+	$par = $lex->tokenizeParallel($in, 4);
+	exit($par == $seq ? 0 : 1);
+}
+pcntl_waitpid($pid, $status);
+var_dump(pcntl_wexitstatus($status));
+
+var_dump($lex->tokenizeParallel($in, 4) == $seq);
+
+?>
+==DONE==
+--EXPECT--
+int(40000)
+int(0)
+bool(true)
+==DONE==
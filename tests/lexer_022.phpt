@@ -0,0 +1,41 @@
+--TEST--
+Hit memory_limit while buffering the input
+--SKIPIF--
+<?php if (!extension_loaded("parle")) print "skip"; ?>
+--INI--
+memory_limit=20M
+--FILE--
+<?php 
+
+use Parle\Lexer;
+use Parle\LexerException;
+use Parle\Token;
+
+$lex = new Lexer;
+$lex->push("[a-z]+", 1);
+$lex->push("\\s+", Token::SKIP);
+$lex->build();
+
+/* The token isn't complete, so feed() keeps the whole input and the
+	second chunk doesn't fit anymore. */
+$s = str_repeat("a", 5 * 1024 * 1024);
+var_dump(count($lex->feed($s)));
+try {
+	$lex->feed($s);
+} catch (LexerException $e) {
+	echo $e->getMessage(), "\n";
+}
+
+/* The lexer is still where it was before the failed call. */
+$toks = $lex->feed("", true);
+var_dump(count($toks), strlen($toks[0]->value), $toks[0]->offset);
+
+?>
+==DONE==
+--EXPECT--
+int(0)
+std::bad_alloc
+int(1)
+int(5242880)
+int(0)
+==DONE==